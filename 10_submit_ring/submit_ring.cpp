@@ -0,0 +1,394 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/*
+Keys:
+  1) MpscRing: a bounded lock-free ring (per-cell sequence numbers), many host threads push, one thread pops.
+  2) SubmitFrontend: producers push work descriptors (copy / kernel launch), never touch the sycl::queue.
+  3) Dispatcher: one thread per queue drains the ring in batches, coalesces adjacent copies and submits them.
+  4) Per-producer enqueue latency (p50 / p99 / max) is recorded by every producer thread.
+  5) Idle dispatcher: after SPIN_ROUNDS empty polls it parks on a condition_variable, a producer only takes the
+     mutex to wake it when `sleeping_` is set, so the fast path stays lock-free.
+
+Why:
+  • memcpy_MT_device in 5_memcpy calls q.memcpy from several threads on one queue, every call takes the
+    runtime's queue lock, so the threads mostly wait for each other.
+  • Here only the dispatcher thread submits, producers only pay for one CAS on the ring tail.
+
+  producer 0 ──┐                                     ┌─ memcpy(dst, src, 4 KB)   <── 4 x 1 KB merged
+  producer 1 ──┼──► [ MpscRing ] ──► dispatcher ──►  ├─ parallel_for(scale)
+  producer 2 ──┘     lock-free       batch + merge   └─ memcpy(...)              ──► in-order sycl::queue
+
+Ring cell protocol (Vyukov bounded queue):
+  • cell.seq == pos            : free, a producer may claim `pos` with CAS on tail.
+  • cell.seq == pos + 1        : published, the consumer may read it.
+  • cell.seq == pos + Capacity : consumed, free again for the next lap.
+
+Ordering:
+  • The dispatcher submits to an in-order queue, so the work of one producer runs in the order it was pushed.
+  • Inside a run of consecutive copies the dispatcher sorts and merges, copies of one run must not overlap,
+    the same requirement as the concurrent q.memcpy calls it replaces.
+*/
+
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity) : mask_(capacity - 1), cells_(new Cell[capacity]) {
+        if (capacity == 0 || (capacity & mask_) != 0)
+            throw std::invalid_argument("MpscRing capacity must be a power of two");
+        for (size_t i = 0; i < capacity; ++i)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Any thread. Returns false if the ring is full.
+    bool try_push(const T &value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = cells_[pos & mask_];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only. Returns false if the next cell is not published yet.
+    bool try_pop(T &value) {
+        Cell &cell = cells_[head_ & mask_];
+        size_t seq = cell.seq.load(std::memory_order_acquire);
+        if (intptr_t(seq) - intptr_t(head_ + 1) < 0)
+            return false;
+        value = cell.value;
+        cell.seq.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_ = 0;
+};
+
+struct KernelArgs {
+    void *ptr[3];
+    size_t n;
+    float alpha;
+};
+
+using LaunchFn = sycl::event (*)(sycl::queue &, const KernelArgs &);
+
+struct Work {
+    enum class Kind { Copy, Kernel } kind;
+    void *dst;
+    const void *src;
+    size_t bytes;
+    LaunchFn launch;
+    KernelArgs args;
+};
+
+// Owned by one producer thread, no sharing.
+struct ProducerStats {
+    std::vector<uint32_t> latency_ns;
+
+    uint32_t percentile(double p) const {
+        if (latency_ns.empty())
+            return 0;
+        std::vector<uint32_t> sorted(latency_ns);
+        size_t idx = std::min(sorted.size() - 1, size_t(p * sorted.size()));
+        std::nth_element(sorted.begin(), sorted.begin() + idx, sorted.end());
+        return sorted[idx];
+    }
+    uint32_t max() const { return latency_ns.empty() ? 0 : *std::max_element(latency_ns.begin(), latency_ns.end()); }
+};
+
+class SubmitFrontend {
+public:
+    SubmitFrontend(sycl::queue &q, size_t capacity = 4096, size_t max_batch = 256)
+        : q_(q), ring_(capacity), max_batch_(max_batch), dispatcher_([this] { run(); }) {}
+
+    ~SubmitFrontend() {
+        flush();
+        {
+            std::lock_guard<std::mutex> lk(park_mutex_);
+            stop_.store(true, std::memory_order_release);
+        }
+        park_cv_.notify_one();
+        dispatcher_.join();
+    }
+
+    void copy(ProducerStats &stats, void *dst, const void *src, size_t bytes) {
+        push(stats, {Work::Kind::Copy, dst, src, bytes, nullptr, {}});
+    }
+
+    void launch(ProducerStats &stats, LaunchFn fn, const KernelArgs &args) {
+        push(stats, {Work::Kind::Kernel, nullptr, nullptr, 0, fn, args});
+    }
+
+    // Wait until everything pushed so far has been submitted and has finished on the device.
+    void flush() {
+        size_t target = enqueued_.load(std::memory_order_acquire);
+        while (submitted_.load(std::memory_order_acquire) < target)
+            std::this_thread::yield();
+        q_.wait();
+    }
+
+    size_t descriptors() const { return submitted_.load(); }
+    size_t batches() const { return batches_.load(); }
+    size_t operations() const { return operations_.load(); }
+    size_t parks() const { return parks_.load(); }
+
+private:
+    void push(ProducerStats &stats, const Work &work) {
+        auto tag_0 = std::chrono::high_resolution_clock::now();
+        while (!ring_.try_push(work))
+            std::this_thread::yield();
+        auto tag_1 = std::chrono::high_resolution_clock::now();
+        // seq_cst pairs with the dispatcher's store to sleeping_ then load of enqueued_: one side sees the other.
+        enqueued_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lk(park_mutex_);
+            park_cv_.notify_one();
+        }
+        stats.latency_ns.push_back(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(tag_1 - tag_0).count()));
+    }
+
+    void run() {
+        std::vector<Work> batch;
+        batch.reserve(max_batch_);
+        size_t popped = 0;
+        int idle = 0;
+        for (;;) {
+            Work work;
+            while (batch.size() < max_batch_ && ring_.try_pop(work))
+                batch.push_back(work);
+
+            if (batch.empty()) {
+                if (stop_.load(std::memory_order_acquire))
+                    return;
+                if (++idle < SPIN_ROUNDS) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                park(popped);
+                idle = 0;
+                continue;
+            }
+
+            idle = 0;
+            popped += batch.size();
+            submit(batch);
+            batches_.fetch_add(1, std::memory_order_relaxed);
+            submitted_.fetch_add(batch.size(), std::memory_order_release);
+            batch.clear();
+        }
+    }
+
+    // Sleep until a producer pushed past `popped` or the front-end stops.
+    void park(size_t popped) {
+        std::unique_lock<std::mutex> lk(park_mutex_);
+        sleeping_.store(true, std::memory_order_seq_cst);
+        park_cv_.wait(lk, [&] {
+            return enqueued_.load(std::memory_order_seq_cst) > popped || stop_.load(std::memory_order_acquire);
+        });
+        sleeping_.store(false, std::memory_order_relaxed);
+        parks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void submit(std::vector<Work> &batch) {
+        auto begin = batch.begin();
+        while (begin != batch.end()) {
+            if (begin->kind == Work::Kind::Kernel) {
+                begin->launch(q_, begin->args);
+                operations_.fetch_add(1, std::memory_order_relaxed);
+                ++begin;
+                continue;
+            }
+            auto end = std::find_if(begin, batch.end(), [](const Work &w) { return w.kind != Work::Kind::Copy; });
+            submit_copies(begin, end);
+            begin = end;
+        }
+    }
+
+    // Merge copies that are contiguous in both source and destination.
+    void submit_copies(std::vector<Work>::iterator begin, std::vector<Work>::iterator end) {
+        std::sort(begin, end, [](const Work &a, const Work &b) { return a.dst < b.dst; });
+        Work merged = *begin;
+        for (auto it = begin + 1; it != end; ++it) {
+            auto *dst_end = static_cast<char *>(merged.dst) + merged.bytes;
+            auto *src_end = static_cast<const char *>(merged.src) + merged.bytes;
+            if (it->dst == dst_end && it->src == src_end) {
+                merged.bytes += it->bytes;
+                continue;
+            }
+            q_.memcpy(merged.dst, merged.src, merged.bytes);
+            operations_.fetch_add(1, std::memory_order_relaxed);
+            merged = *it;
+        }
+        q_.memcpy(merged.dst, merged.src, merged.bytes);
+        operations_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    sycl::queue &q_;
+    MpscRing<Work> ring_;
+    const size_t max_batch_;
+    std::atomic<bool> stop_{false};
+    std::atomic<size_t> enqueued_{0};
+    std::atomic<size_t> submitted_{0};
+    std::atomic<size_t> batches_{0};
+    std::atomic<size_t> operations_{0};
+    std::atomic<size_t> parks_{0};
+
+    // Parking of the idle dispatcher
+    static constexpr int SPIN_ROUNDS = 1024;
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    std::atomic<bool> sleeping_{false};
+
+    std::thread dispatcher_;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Benchmark: THREADS producers, each copies its own partition in CHUNK pieces, then scales each piece on the device.
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr int THREADS = 4;
+constexpr size_t N = 1024 * 1024;
+constexpr size_t CHUNK = 256;
+
+sycl::event ScaleKernel(sycl::queue &q, const KernelArgs &args) {
+    float *data = static_cast<float *>(args.ptr[0]);
+    float alpha = args.alpha;
+    return q.parallel_for(args.n, [=](auto i) { data[i] *= alpha; });
+}
+
+template <typename Fn>
+long TimeUs(Fn &&fn) {
+    auto tag_0 = std::chrono::high_resolution_clock::now();
+    fn();
+    auto tag_1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(tag_1 - tag_0).count();
+}
+
+// Run `body(thread_id)` on THREADS threads.
+template <typename Fn>
+void Producers(Fn &&body) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t)
+        threads.emplace_back(body, t);
+    for (auto &th : threads)
+        th.join();
+}
+
+int Check(sycl::queue &q, const float *data_gpu, float expect) {
+    std::vector<float> out(N);
+    q.memcpy(out.data(), data_gpu, N * sizeof(float)).wait();
+    int errors = 0;
+    for (size_t i = 0; i < N; ++i)
+        errors += out[i] != expect;
+    return errors;
+}
+
+int main() {
+    sycl::queue q{sycl::property::queue::in_order()};
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    float *data_cpu_pinned = sycl::malloc_host<float>(N, q);
+    float *data_gpu = sycl::malloc_device<float>(N, q);
+    std::fill(data_cpu_pinned, data_cpu_pinned + N, 1.0f);
+    const size_t per_thread = N / CHUNK / THREADS;
+
+    {
+        q.fill(data_gpu, 0.0f, N).wait();
+        auto us = TimeUs([&] {
+            Producers([&](int t) {
+                for (size_t c = t * per_thread; c < (t + 1) * per_thread; ++c)
+                    q.memcpy(data_gpu + c * CHUNK, data_cpu_pinned + c * CHUNK, CHUNK * sizeof(float));
+            });
+            q.wait();
+        });
+        std::cout << "direct q.memcpy:       " << us << " usec, errors: " << Check(q, data_gpu, 1.0f) << std::endl;
+    }
+
+    {
+        q.fill(data_gpu, 0.0f, N).wait();
+        std::vector<ProducerStats> stats(THREADS);
+        SubmitFrontend frontend(q);
+        auto us = TimeUs([&] {
+            Producers([&](int t) {
+                for (size_t c = t * per_thread; c < (t + 1) * per_thread; ++c)
+                    frontend.copy(stats[t], data_gpu + c * CHUNK, data_cpu_pinned + c * CHUNK, CHUNK * sizeof(float));
+            });
+            frontend.flush();
+        });
+        std::cout << "ring copy:             " << us << " usec, errors: " << Check(q, data_gpu, 1.0f)
+                  << ", descriptors: " << frontend.descriptors() << ", batches: " << frontend.batches()
+                  << ", submitted ops: " << frontend.operations() << ", parks: " << frontend.parks() << std::endl;
+        for (int t = 0; t < THREADS; ++t)
+            std::cout << "  producer " << t << " enqueue latency p50/p99/max: " << stats[t].percentile(0.5) << "/"
+                      << stats[t].percentile(0.99) << "/" << stats[t].max() << " ns" << std::endl;
+    }
+
+    {
+        q.fill(data_gpu, 0.0f, N).wait();
+        auto us = TimeUs([&] {
+            Producers([&](int t) {
+                for (size_t c = t * per_thread; c < (t + 1) * per_thread; ++c) {
+                    q.memcpy(data_gpu + c * CHUNK, data_cpu_pinned + c * CHUNK, CHUNK * sizeof(float));
+                    ScaleKernel(q, {{data_gpu + c * CHUNK}, CHUNK, 2.0f});
+                }
+            });
+            q.wait();
+        });
+        std::cout << "direct copy + kernel:  " << us << " usec, errors: " << Check(q, data_gpu, 2.0f) << std::endl;
+    }
+
+    {
+        q.fill(data_gpu, 0.0f, N).wait();
+        std::vector<ProducerStats> stats(THREADS);
+        SubmitFrontend frontend(q);
+        auto us = TimeUs([&] {
+            Producers([&](int t) {
+                for (size_t c = t * per_thread; c < (t + 1) * per_thread; ++c) {
+                    frontend.copy(stats[t], data_gpu + c * CHUNK, data_cpu_pinned + c * CHUNK, CHUNK * sizeof(float));
+                    frontend.launch(stats[t], ScaleKernel, {{data_gpu + c * CHUNK}, CHUNK, 2.0f});
+                }
+            });
+            frontend.flush();
+        });
+        std::cout << "ring copy + kernel:    " << us << " usec, errors: " << Check(q, data_gpu, 2.0f)
+                  << ", descriptors: " << frontend.descriptors() << ", batches: " << frontend.batches()
+                  << ", submitted ops: " << frontend.operations() << ", parks: " << frontend.parks() << std::endl;
+        for (int t = 0; t < THREADS; ++t)
+            std::cout << "  producer " << t << " enqueue latency p50/p99/max: " << stats[t].percentile(0.5) << "/"
+                      << stats[t].percentile(0.99) << "/" << stats[t].max() << " ns" << std::endl;
+    }
+
+    sycl::free(data_cpu_pinned, q);
+    sycl::free(data_gpu, q);
+    return 0;
+}
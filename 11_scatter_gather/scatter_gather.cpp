@@ -0,0 +1,379 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+/*
+Keys:
+  1) CopyRegion / Strided2D / Strided3D: describe many small, non-contiguous pieces of one transfer.
+  2) Coalesce: pieces that are contiguous in both source and destination are merged into one.
+  3) Pack: small pieces are packed into one pinned staging buffer, moved with ONE q.memcpy,
+     and unpacked on the device by ONE kernel (one work-group per piece).
+  4) Large pieces (>= direct_threshold) are still copied with their own q.memcpy, packing them buys nothing.
+
+Host -> device (to_device):
+
+  host pieces ──pack──► pinned staging [ table | p0 | p1 | p2 ... ] ──1x memcpy──► device staging
+                                                                                       │ unpack kernel
+                                                                                       ▼
+                                                                        dst0   dst1   dst2 ... (device)
+
+Device -> host (to_host):
+
+  table ──memcpy──► device staging, gather kernel packs device pieces behind it ──1x memcpy──► pinned staging
+  ──unpack (host memcpy)──► dst0 dst1 dst2 ... (host)
+
+Why:
+  • Every q.memcpy pays a fixed submission + driver cost of several usec, for a 256 B piece this is
+    orders of magnitude more than moving the bytes.
+  • The piece table travels in the same staging buffer as the data, so it costs no extra transfer.
+*/
+
+struct CopyRegion {
+    const void *src;
+    void *dst;
+    size_t bytes;
+};
+
+// `height` rows of `width_bytes`, rows are `src_pitch` / `dst_pitch` bytes apart.
+struct Strided2D {
+    const void *src;
+    void *dst;
+    size_t width_bytes;
+    size_t height;
+    size_t src_pitch;
+    size_t dst_pitch;
+};
+
+// `depth` slices of a Strided2D, slices are `src_slice_pitch` / `dst_slice_pitch` bytes apart.
+struct Strided3D {
+    Strided2D slice;
+    size_t depth;
+    size_t src_slice_pitch;
+    size_t dst_slice_pitch;
+};
+
+inline void Append(std::vector<CopyRegion> &regions, const Strided2D &d) {
+    auto *src = static_cast<const char *>(d.src);
+    auto *dst = static_cast<char *>(d.dst);
+    for (size_t row = 0; row < d.height; ++row)
+        regions.push_back({src + row * d.src_pitch, dst + row * d.dst_pitch, d.width_bytes});
+}
+
+inline void Append(std::vector<CopyRegion> &regions, const Strided3D &d) {
+    for (size_t z = 0; z < d.depth; ++z) {
+        Strided2D slice = d.slice;
+        slice.src = static_cast<const char *>(d.slice.src) + z * d.src_slice_pitch;
+        slice.dst = static_cast<char *>(d.slice.dst) + z * d.dst_slice_pitch;
+        Append(regions, slice);
+    }
+}
+
+// Merge pieces contiguous in both source and destination. Pieces must not overlap.
+inline void Coalesce(std::vector<CopyRegion> &regions) {
+    if (regions.empty())
+        return;
+    std::sort(regions.begin(), regions.end(), [](const CopyRegion &a, const CopyRegion &b) {
+        return std::less<const void *>()(a.src, b.src);
+    });
+    size_t out = 0;
+    for (size_t i = 1; i < regions.size(); ++i) {
+        CopyRegion &last = regions[out];
+        if (static_cast<const char *>(last.src) + last.bytes == regions[i].src &&
+            static_cast<char *>(last.dst) + last.bytes == regions[i].dst)
+            last.bytes += regions[i].bytes;
+        else
+            regions[++out] = regions[i];
+    }
+    regions.resize(out + 1);
+}
+
+class TransferEngine {
+public:
+    struct Stats {
+        size_t pieces = 0;    // as passed in
+        size_t coalesced = 0; // after Coalesce
+        size_t direct = 0;    // large pieces with their own memcpy
+        size_t packed = 0;    // pieces moved through the staging buffer
+        size_t rounds = 0;    // staging round trips
+    };
+
+    TransferEngine(sycl::queue &q, size_t staging_bytes = 4 << 20, size_t direct_threshold = 64 * 1024)
+        : q_(q), capacity_(staging_bytes), direct_threshold_(std::min(direct_threshold, staging_bytes / 2)) {
+        host_staging_ = sycl::malloc_host<char>(capacity_, q_);
+        dev_staging_ = sycl::malloc_device<char>(capacity_, q_);
+    }
+
+    ~TransferEngine() {
+        q_.wait();
+        sycl::free(host_staging_, q_);
+        sycl::free(dev_staging_, q_);
+    }
+
+    TransferEngine(const TransferEngine &) = delete;
+    TransferEngine &operator=(const TransferEngine &) = delete;
+
+    // src: host memory, dst: device memory. Blocks until every piece has arrived on the device.
+    void to_device(std::vector<CopyRegion> regions) { transfer(std::move(regions), Direction::ToDevice); }
+    // src: device memory, dst: host memory. Blocks until every piece has arrived in host memory.
+    void to_host(std::vector<CopyRegion> regions) { transfer(std::move(regions), Direction::ToHost); }
+
+    const Stats &stats() const { return stats_; }
+
+private:
+    enum class Direction { ToDevice, ToHost };
+
+    // One entry of the table at the start of the staging buffer.
+    struct Piece {
+        uint64_t offset; // into the staging buffer
+        uint64_t bytes;
+        const char *src; // device source for ToHost
+        char *dst;       // device destination for ToDevice, host destination for ToHost
+    };
+
+    static constexpr size_t kAlign = 16;
+    static constexpr size_t kWorkGroup = 128;
+
+    static size_t AlignUp(size_t v) { return (v + kAlign - 1) / kAlign * kAlign; }
+
+    void transfer(std::vector<CopyRegion> regions, Direction dir) {
+        stats_.pieces += regions.size();
+        Coalesce(regions);
+        stats_.coalesced += regions.size();
+
+        std::vector<sycl::event> direct;
+        std::vector<CopyRegion> small;
+        for (auto &r : regions) {
+            if (r.bytes >= direct_threshold_) {
+                direct.push_back(q_.memcpy(r.dst, r.src, r.bytes));
+                ++stats_.direct;
+            } else {
+                small.push_back(r);
+            }
+        }
+
+        size_t begin = 0;
+        while (begin < small.size()) {
+            // Take as many pieces as fit behind their table.
+            size_t end = begin, data_bytes = 0;
+            while (end < small.size() &&
+                   AlignUp((end - begin + 1) * sizeof(Piece)) + data_bytes + AlignUp(small[end].bytes) <= capacity_) {
+                data_bytes += AlignUp(small[end].bytes);
+                ++end;
+            }
+            if (dir == Direction::ToDevice)
+                round_to_device(small, begin, end);
+            else
+                round_to_host(small, begin, end);
+            stats_.packed += end - begin;
+            ++stats_.rounds;
+            begin = end;
+        }
+
+        for (auto &e : direct)
+            e.wait();
+        last_.wait();
+    }
+
+    // Fill the table for pieces [begin, end) and return the number of bytes used by table + data.
+    size_t build_table(const std::vector<CopyRegion> &pieces, size_t begin, size_t end, Direction dir) {
+        auto *table = reinterpret_cast<Piece *>(host_staging_);
+        size_t offset = AlignUp((end - begin) * sizeof(Piece));
+        for (size_t i = begin; i < end; ++i) {
+            const CopyRegion &r = pieces[i];
+            table[i - begin] = {offset, r.bytes, dir == Direction::ToHost ? static_cast<const char *>(r.src) : nullptr,
+                                static_cast<char *>(r.dst)};
+            if (dir == Direction::ToDevice)
+                std::memcpy(host_staging_ + offset, r.src, r.bytes);
+            offset += AlignUp(r.bytes);
+        }
+        return offset;
+    }
+
+    // Copy one piece with the whole work-group, 4 bytes per work-item when both sides allow it.
+    static void CopyPiece(sycl::nd_item<1> item, char *dst, const char *src, size_t bytes) {
+        const size_t lid = item.get_local_id(0);
+        const size_t wg = item.get_local_range(0);
+        if (((reinterpret_cast<uintptr_t>(dst) | reinterpret_cast<uintptr_t>(src) | bytes) & 3) == 0) {
+            auto *d = reinterpret_cast<uint32_t *>(dst);
+            auto *s = reinterpret_cast<const uint32_t *>(src);
+            for (size_t i = lid; i < bytes / 4; i += wg)
+                d[i] = s[i];
+        } else {
+            for (size_t i = lid; i < bytes; i += wg)
+                dst[i] = src[i];
+        }
+    }
+
+    // Asynchronous, the unpack kernel is left in last_.
+    void round_to_device(const std::vector<CopyRegion> &pieces, size_t begin, size_t end) {
+        // The pinned staging buffer is reused, the previous round must have left it.
+        last_.wait();
+        size_t used = build_table(pieces, begin, end, Direction::ToDevice);
+        auto upload = q_.memcpy(dev_staging_, host_staging_, used);
+
+        char *staging = dev_staging_;
+        size_t count = end - begin;
+        last_ = q_.submit([&](sycl::handler &h) {
+            h.depends_on(upload);
+            h.parallel_for(sycl::nd_range<1>(count * kWorkGroup, kWorkGroup), [=](sycl::nd_item<1> item) {
+                const Piece p = reinterpret_cast<const Piece *>(staging)[item.get_group(0)];
+                CopyPiece(item, p.dst, staging + p.offset, p.bytes);
+            });
+        });
+    }
+
+    // Synchronous, the host unpack needs the data.
+    void round_to_host(const std::vector<CopyRegion> &pieces, size_t begin, size_t end) {
+        last_.wait();
+        size_t count = end - begin;
+        size_t table_bytes = AlignUp(count * sizeof(Piece));
+        size_t used = build_table(pieces, begin, end, Direction::ToHost);
+        auto upload = q_.memcpy(dev_staging_, host_staging_, table_bytes);
+
+        char *staging = dev_staging_;
+        auto pack = q_.submit([&](sycl::handler &h) {
+            h.depends_on(upload);
+            h.parallel_for(sycl::nd_range<1>(count * kWorkGroup, kWorkGroup), [=](sycl::nd_item<1> item) {
+                const Piece p = reinterpret_cast<const Piece *>(staging)[item.get_group(0)];
+                CopyPiece(item, staging + p.offset, p.src, p.bytes);
+            });
+        });
+        q_.memcpy(host_staging_ + table_bytes, dev_staging_ + table_bytes, used - table_bytes, pack).wait();
+
+        // The host table is still intact, unpack on the host.
+        const auto *table = reinterpret_cast<const Piece *>(host_staging_);
+        for (size_t i = 0; i < count; ++i)
+            std::memcpy(table[i].dst, host_staging_ + table[i].offset, table[i].bytes);
+        last_ = sycl::event();
+    }
+
+    sycl::queue &q_;
+    const size_t capacity_;
+    const size_t direct_threshold_;
+    char *host_staging_ = nullptr;
+    char *dev_staging_ = nullptr;
+    sycl::event last_;
+    Stats stats_;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr int ITERS = 10;
+
+// One warm-up run (JIT compilation of the pack / unpack kernels, first-touch of the staging buffers),
+// then the average over ITERS runs, in usec.
+template <typename Fn>
+long TimeUs(Fn &&fn) {
+    fn();
+    auto tag_0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < ITERS; ++i)
+        fn();
+    auto tag_1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(tag_1 - tag_0).count() / ITERS;
+}
+
+// Stats accumulate over the warm-up and the timed runs, print them per run.
+void PrintStats(const TransferEngine::Stats &s) {
+    constexpr size_t runs = ITERS + 1;
+    std::cout << "    per run, pieces: " << s.pieces / runs << ", after coalesce: " << s.coalesced / runs
+              << ", direct: " << s.direct / runs << ", packed: " << s.packed / runs
+              << ", staging rounds: " << s.rounds / runs << std::endl;
+}
+
+int main() {
+    sycl::queue q;
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    // KV-slice like layout: PIECES slices of SLICE bytes, scattered with a stride on both sides.
+    constexpr size_t PIECES = 512;
+    constexpr size_t SLICE = 256;
+    constexpr size_t STRIDE = 4 * SLICE;
+    constexpr size_t BYTES = PIECES * STRIDE;
+
+    char *host_src = sycl::malloc_host<char>(BYTES, q);
+    char *host_dst = sycl::malloc_host<char>(BYTES, q);
+    char *dev = sycl::malloc_device<char>(BYTES, q);
+    for (size_t i = 0; i < BYTES; ++i)
+        host_src[i] = char(i * 7 + 3);
+
+    std::vector<CopyRegion> scatter, gather;
+    for (size_t i = 0; i < PIECES; ++i) {
+        // Reverse the order on the device side, nothing is contiguous.
+        size_t j = PIECES - 1 - i;
+        scatter.push_back({host_src + i * STRIDE, dev + j * STRIDE, SLICE});
+        gather.push_back({dev + j * STRIDE, host_dst + i * STRIDE, SLICE});
+    }
+
+    auto check = [&](const char *name, long us) {
+        int errors = 0;
+        for (size_t i = 0; i < PIECES; ++i)
+            errors += std::memcmp(host_src + i * STRIDE, host_dst + i * STRIDE, SLICE) != 0;
+        std::cout << name << us << " usec, errors: " << errors << std::endl;
+    };
+
+    {
+        q.memset(dev, 0, BYTES).wait();
+        std::memset(host_dst, 0, BYTES);
+        long us = TimeUs([&] {
+            for (auto &r : scatter)
+                q.memcpy(r.dst, r.src, r.bytes);
+            q.wait();
+            for (auto &r : gather)
+                q.memcpy(r.dst, r.src, r.bytes);
+            q.wait();
+        });
+        check("N x q.memcpy (scatter + gather):   ", us);
+    }
+
+    {
+        q.memset(dev, 0, BYTES).wait();
+        std::memset(host_dst, 0, BYTES);
+        TransferEngine engine(q);
+        long us = TimeUs([&] {
+            engine.to_device(scatter);
+            engine.to_host(gather);
+        });
+        check("TransferEngine (scatter + gather): ", us);
+        PrintStats(engine.stats());
+    }
+
+    // 2D: a ROWS x COLS float sub-block out of a LD-wide host matrix into a dense device block, and back.
+    {
+        constexpr size_t LD = 1024, ROWS = 64, COLS = 128;
+        std::vector<float> host_matrix(LD * LD), host_block(ROWS * LD, 0.0f);
+        for (size_t i = 0; i < host_matrix.size(); ++i)
+            host_matrix[i] = float(i);
+        float *dev_block = sycl::malloc_device<float>(ROWS * COLS, q);
+
+        TransferEngine engine(q);
+        std::vector<CopyRegion> up, down;
+        Append(up, Strided2D{host_matrix.data() + 3 * LD + 256, dev_block, COLS * sizeof(float), ROWS,
+                             LD * sizeof(float), COLS * sizeof(float)});
+        Append(down, Strided2D{dev_block, host_block.data(), COLS * sizeof(float), ROWS, COLS * sizeof(float),
+                               LD * sizeof(float)});
+        long us = TimeUs([&] {
+            engine.to_device(up);
+            engine.to_host(down);
+        });
+
+        int errors = 0;
+        for (size_t r = 0; r < ROWS; ++r)
+            for (size_t c = 0; c < COLS; ++c)
+                errors += host_block[r * LD + c] != host_matrix[(r + 3) * LD + 256 + c];
+        std::cout << "Strided2D " << ROWS << "x" << COLS << " block:        " << us << " usec, errors: " << errors
+                  << std::endl;
+        PrintStats(engine.stats());
+        sycl::free(dev_block, q);
+    }
+
+    sycl::free(host_src, q);
+    sycl::free(host_dst, q);
+    sycl::free(dev, q);
+    return 0;
+}
@@ -0,0 +1,389 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+Keys:
+  1) Block arena: K and V live in fixed-size blocks of `block_size` tokens, carved out of one USM device allocation.
+  2) Block table: every sequence is a list of block ids, token t lives in block table[t / block_size],
+     slot t % block_size. Sequences grow one block at a time, no reallocation, no fragmentation.
+  3) fork(): a child sequence shares all blocks of its parent (refcount), e.g. a common system prompt.
+     The first append into a shared, partially filled block copies it first (copy-on-write).
+  4) Attention-read kernel: one work-group per (sequence, head), keys and values are gathered through the block table.
+
+Layout:
+  4_subgroup / 7_reduction store one dense [sequence_length][head_num][head_size] vector per call.
+  Here every block is [block_size][head_num][head_size], for K and for V:
+
+    seq 0 table: [ 3 | 7 | 1 ]          arena: | b0 | b1 | b2 | b3 | b4 | b5 | b6 | b7 | ...
+    seq 1 table: [ 3 | 7 | 5 ]                         ▲         ▲              ▲
+                   └───┴── shared prefix (refcount 2)  └ seq 0   └ seq 0/1      └ seq 0/1
+                                                         tail
+
+  A contiguous cache must reserve max_context tokens per sequence up front, the paged cache only
+  reserves what is used, rounded up to one block.
+
+Note: the cache submits to an in-order queue, so appends, copy-on-write and attention run in submission order.
+*/
+
+constexpr int head_num = 8;
+constexpr int head_size = 64;
+constexpr int block_size = 16;
+constexpr int token_elems = head_num * head_size;
+constexpr int block_elems = block_size * token_elems;
+
+class PagedKVCache {
+public:
+    PagedKVCache(sycl::queue &q, int num_blocks, int max_batch = 256)
+        : q_(q), num_blocks_(num_blocks), max_batch_(max_batch), refcount_(num_blocks, 0) {
+        if (!q_.is_in_order())
+            throw std::invalid_argument("PagedKVCache needs an in-order queue");
+        k_arena_ = sycl::malloc_device<float>(size_t(num_blocks) * block_elems, q_);
+        v_arena_ = sycl::malloc_device<float>(size_t(num_blocks) * block_elems, q_);
+        slots_ = sycl::malloc_device<int>(max_batch, q_);
+        for (int b = num_blocks - 1; b >= 0; --b)
+            free_blocks_.push_back(b);
+    }
+
+    ~PagedKVCache() {
+        q_.wait();
+        sycl::free(k_arena_, q_);
+        sycl::free(v_arena_, q_);
+        sycl::free(slots_, q_);
+        sycl::free(tables_, q_);
+    }
+
+    PagedKVCache(const PagedKVCache &) = delete;
+    PagedKVCache &operator=(const PagedKVCache &) = delete;
+
+    int add_sequence() { return insert({{}, 0, true}); }
+
+    // New sequence sharing every block (and the length) of `parent`.
+    int fork(int parent) {
+        Sequence child = seq(parent);
+        for (int b : child.blocks)
+            ++refcount_[b];
+        return insert(std::move(child));
+    }
+
+    // The id is recycled by a later add_sequence() / fork().
+    void free_sequence(int id) {
+        Sequence &s = seq(id);
+        for (int b : s.blocks)
+            release(b);
+        s = {{}, 0, false};
+        free_ids_.push_back(id);
+    }
+
+    // Append one token to each sequence in `ids`.
+    // k, v: device pointers, [ids.size()][head_num][head_size].
+    void append(const std::vector<int> &ids, const float *k, const float *v) {
+        if (int(ids.size()) > max_batch_)
+            throw std::invalid_argument("PagedKVCache::append: batch larger than max_batch");
+
+        std::vector<int> slots(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            Sequence &s = seq(ids[i]);
+            int offset = s.length % block_size;
+            if (offset == 0) {
+                s.blocks.push_back(allocate());
+            } else if (refcount_[s.blocks.back()] > 1) {
+                s.blocks.back() = copy_on_write(s.blocks.back());
+            }
+            slots[i] = s.blocks.back() * block_size + offset;
+            ++s.length;
+        }
+
+        q_.memcpy(slots_, slots.data(), slots.size() * sizeof(int));
+        float *k_arena = k_arena_, *v_arena = v_arena_;
+        const int *slot_ids = slots_;
+        q_.parallel_for(sycl::range<2>(ids.size(), token_elems), [=](sycl::item<2> it) {
+            size_t b = it.get_id(0), e = it.get_id(1);
+            size_t dst = size_t(slot_ids[b]) * token_elems + e;
+            k_arena[dst] = k[b * token_elems + e];
+            v_arena[dst] = v[b * token_elems + e];
+        }).wait();
+    }
+
+    // Decode attention for one query token per sequence.
+    // query, out: device pointers, [ids.size()][head_num][head_size]. A sequence without tokens gets a zero output.
+    sycl::event attention(const std::vector<int> &ids, const float *query, float *out) {
+        int max_blocks = 1;
+        for (int id : ids)
+            max_blocks = std::max(max_blocks, int(seq(id).blocks.size()));
+
+        // Flatten the block tables, [ids.size()][max_blocks], plus the context length of each sequence.
+        std::vector<int> tables(ids.size() * max_blocks, 0), lens(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            const Sequence &s = seq(ids[i]);
+            std::copy(s.blocks.begin(), s.blocks.end(), tables.begin() + i * max_blocks);
+            lens[i] = s.length;
+        }
+        if (tables.size() + lens.size() > tables_capacity_) {
+            q_.wait();
+            sycl::free(tables_, q_);
+            tables_capacity_ = 2 * (tables.size() + lens.size());
+            tables_ = sycl::malloc_device<int>(tables_capacity_, q_);
+        }
+        int *d_tables = tables_;
+        int *d_lens = tables_ + tables.size();
+        q_.memcpy(d_tables, tables.data(), tables.size() * sizeof(int));
+        // `tables` and `lens` go out of scope on return, the copies must have finished by then.
+        q_.memcpy(d_lens, lens.data(), lens.size() * sizeof(int)).wait();
+
+        constexpr int WG = 64;
+        const float *k_arena = k_arena_, *v_arena = v_arena_;
+        auto e = q_.parallel_for(sycl::nd_range<1>(ids.size() * head_num * WG, WG), [=](sycl::nd_item<1> item) {
+            auto grp = item.get_group();
+            const int s = item.get_group(0) / head_num;
+            const int head = item.get_group(0) % head_num;
+            const int lid = item.get_local_id(0);
+            const int len = d_lens[s];
+            const int *table = d_tables + s * max_blocks;
+            const float *qv = query + (s * head_num + head) * head_size;
+            const float scale = 1.0f / sycl::sqrt(float(head_size));
+
+            auto token = [=](int t) {
+                return (size_t(table[t / block_size]) * block_size + t % block_size) * token_elems + head * head_size;
+            };
+            auto score = [=](int t) {
+                const float *kv = k_arena + token(t);
+                float dot = 0.0f;
+                for (int d = 0; d < head_size; ++d)
+                    dot += qv[d] * kv[d];
+                return dot * scale;
+            };
+
+            float m = -INFINITY;
+            for (int t = lid; t < len; t += WG)
+                m = sycl::max(m, score(t));
+            m = sycl::reduce_over_group(grp, m, sycl::maximum<float>());
+
+            float sum = 0.0f;
+            float acc[head_size] = {};
+            for (int t = lid; t < len; t += WG) {
+                float w = sycl::exp(score(t) - m);
+                const float *vv = v_arena + token(t);
+                sum += w;
+                for (int d = 0; d < head_size; ++d)
+                    acc[d] += w * vv[d];
+            }
+            sum = sycl::reduce_over_group(grp, sum, sycl::plus<float>());
+
+            float *o = out + (s * head_num + head) * head_size;
+            for (int d = 0; d < head_size; ++d) {
+                float v = sycl::reduce_over_group(grp, acc[d], sycl::plus<float>());
+                if (lid == 0)
+                    o[d] = len > 0 ? v / sum : 0.0f;
+            }
+        });
+        return e;
+    }
+
+    int length(int id) { return seq(id).length; }
+    int sequence_slots() const { return int(seqs_.size()); }
+    int used_blocks() const { return num_blocks_ - int(free_blocks_.size()); }
+    int shared_blocks() const { return int(std::count_if(refcount_.begin(), refcount_.end(), [](int r) { return r > 1; })); }
+    int cow_copies() const { return cow_copies_; }
+
+private:
+    struct Sequence {
+        std::vector<int> blocks;
+        int length;
+        bool live;
+    };
+
+    Sequence &seq(int id) {
+        if (id < 0 || id >= int(seqs_.size()) || !seqs_[id].live)
+            throw std::invalid_argument("PagedKVCache: unknown sequence " + std::to_string(id));
+        return seqs_[id];
+    }
+
+    int insert(Sequence s) {
+        if (free_ids_.empty()) {
+            seqs_.push_back(std::move(s));
+            return int(seqs_.size()) - 1;
+        }
+        int id = free_ids_.back();
+        free_ids_.pop_back();
+        seqs_[id] = std::move(s);
+        return id;
+    }
+
+    int allocate() {
+        if (free_blocks_.empty())
+            throw std::runtime_error("PagedKVCache: out of blocks");
+        int b = free_blocks_.back();
+        free_blocks_.pop_back();
+        refcount_[b] = 1;
+        return b;
+    }
+
+    void release(int b) {
+        if (--refcount_[b] == 0)
+            free_blocks_.push_back(b);
+    }
+
+    int copy_on_write(int shared) {
+        int b = allocate();
+        q_.memcpy(k_arena_ + size_t(b) * block_elems, k_arena_ + size_t(shared) * block_elems, block_elems * sizeof(float));
+        q_.memcpy(v_arena_ + size_t(b) * block_elems, v_arena_ + size_t(shared) * block_elems, block_elems * sizeof(float));
+        release(shared);
+        ++cow_copies_;
+        return b;
+    }
+
+    sycl::queue &q_;
+    const int num_blocks_;
+    const int max_batch_;
+    float *k_arena_ = nullptr;
+    float *v_arena_ = nullptr;
+    int *slots_ = nullptr;
+    int *tables_ = nullptr; // flattened block tables + context lengths for attention()
+    size_t tables_capacity_ = 0;
+    std::vector<int> refcount_;
+    std::vector<int> free_blocks_;
+    std::vector<Sequence> seqs_;
+    std::vector<int> free_ids_;
+    int cow_copies_ = 0;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example: a shared prompt, forked into several sequences that decode independently.
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr int num_seqs = 8;
+constexpr int prefix_length = 40;
+constexpr int decode_steps = 24;
+
+// Dense host copy of every sequence for the reference check, [token][head_num][head_size].
+struct HostSequence {
+    std::vector<float> k, v;
+};
+
+inline float Value(int seq, int token, int e, float scale) {
+    return scale * std::sin(0.37f * seq + 0.11f * token + 0.013f * e);
+}
+
+void HostAttention(const HostSequence &s, const float *query, float *out) {
+    const int len = int(s.k.size()) / token_elems;
+    for (int head = 0; head < head_num; ++head) {
+        const float *qv = query + head * head_size;
+        std::vector<float> scores(len);
+        float m = -INFINITY;
+        for (int t = 0; t < len; ++t) {
+            float dot = 0.0f;
+            for (int d = 0; d < head_size; ++d)
+                dot += qv[d] * s.k[t * token_elems + head * head_size + d];
+            scores[t] = dot / std::sqrt(float(head_size));
+            m = std::max(m, scores[t]);
+        }
+        float sum = 0.0f;
+        for (int t = 0; t < len; ++t)
+            sum += scores[t] = std::exp(scores[t] - m);
+        for (int d = 0; d < head_size; ++d) {
+            float acc = 0.0f;
+            for (int t = 0; t < len; ++t)
+                acc += scores[t] * s.v[t * token_elems + head * head_size + d];
+            out[head * head_size + d] = acc / sum;
+        }
+    }
+}
+
+int main() {
+    sycl::queue q{sycl::property::queue::in_order()};
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    PagedKVCache cache(q, 256);
+    std::vector<HostSequence> host(num_seqs);
+    float *d_k = sycl::malloc_device<float>(num_seqs * token_elems, q);
+    float *d_v = sycl::malloc_device<float>(num_seqs * token_elems, q);
+    std::vector<float> h_k(num_seqs * token_elems), h_v(num_seqs * token_elems);
+
+    // Prefill the shared prompt into sequence 0, token by token.
+    int root = cache.add_sequence();
+    for (int t = 0; t < prefix_length; ++t) {
+        for (int e = 0; e < token_elems; ++e) {
+            h_k[e] = Value(0, t, e, 1.0f);
+            h_v[e] = Value(0, t, e, 0.5f);
+        }
+        q.memcpy(d_k, h_k.data(), token_elems * sizeof(float));
+        q.memcpy(d_v, h_v.data(), token_elems * sizeof(float));
+        cache.append({root}, d_k, d_v);
+        host[0].k.insert(host[0].k.end(), h_k.begin(), h_k.begin() + token_elems);
+        host[0].v.insert(host[0].v.end(), h_v.begin(), h_v.begin() + token_elems);
+    }
+
+    std::vector<int> ids = {root};
+    for (int s = 1; s < num_seqs; ++s) {
+        ids.push_back(cache.fork(root));
+        host[s] = host[0];
+    }
+    std::cout << "after prefill + fork: used blocks " << cache.used_blocks() << ", shared blocks "
+              << cache.shared_blocks() << std::endl;
+
+    // Decode: every sequence appends its own token each step.
+    for (int step = 0; step < decode_steps; ++step) {
+        int t = prefix_length + step;
+        for (int s = 0; s < num_seqs; ++s) {
+            for (int e = 0; e < token_elems; ++e) {
+                h_k[s * token_elems + e] = Value(s, t, e, 1.0f);
+                h_v[s * token_elems + e] = Value(s, t, e, 0.5f);
+            }
+            host[s].k.insert(host[s].k.end(), h_k.begin() + s * token_elems, h_k.begin() + (s + 1) * token_elems);
+            host[s].v.insert(host[s].v.end(), h_v.begin() + s * token_elems, h_v.begin() + (s + 1) * token_elems);
+        }
+        q.memcpy(d_k, h_k.data(), h_k.size() * sizeof(float));
+        q.memcpy(d_v, h_v.data(), h_v.size() * sizeof(float));
+        cache.append(ids, d_k, d_v);
+    }
+    std::cout << "after " << decode_steps << " decode steps: used blocks " << cache.used_blocks() << ", shared blocks "
+              << cache.shared_blocks() << ", copy-on-write copies " << cache.cow_copies() << std::endl;
+
+    const int context = prefix_length + decode_steps;
+    std::cout << "paged KV bytes:      " << size_t(cache.used_blocks()) * block_elems * 2 * sizeof(float) << std::endl;
+    std::cout << "contiguous KV bytes: " << size_t(num_seqs) * context * token_elems * 2 * sizeof(float)
+              << " (exact length, no headroom)" << std::endl;
+
+    // Attention over the paged cache vs. the dense host reference.
+    std::vector<float> h_q(num_seqs * token_elems), h_out(num_seqs * token_elems), ref(token_elems);
+    for (size_t i = 0; i < h_q.size(); ++i)
+        h_q[i] = 0.1f * std::cos(0.07f * i);
+    float *d_q = sycl::malloc_device<float>(h_q.size(), q);
+    float *d_out = sycl::malloc_device<float>(h_out.size(), q);
+    q.memcpy(d_q, h_q.data(), h_q.size() * sizeof(float));
+    cache.attention(ids, d_q, d_out);
+    q.memcpy(h_out.data(), d_out, h_out.size() * sizeof(float)).wait();
+
+    int errors = 0;
+    for (int s = 0; s < num_seqs; ++s) {
+        HostAttention(host[s], h_q.data() + s * token_elems, ref.data());
+        for (int e = 0; e < token_elems; ++e)
+            if (std::abs(ref[e] - h_out[s * token_elems + e]) > 1e-4f)
+                ++errors;
+    }
+    std::cout << "attention errors: " << errors << std::endl;
+
+    for (int id : ids)
+        cache.free_sequence(id);
+    std::cout << "after free: used blocks " << cache.used_blocks() << std::endl;
+
+    // Freed ids are recycled, and a sequence without tokens attends to nothing (zero output, no 0/0).
+    int fresh = cache.add_sequence();
+    cache.attention({fresh}, d_q, d_out);
+    q.memcpy(h_out.data(), d_out, token_elems * sizeof(float)).wait();
+    for (int e = 0; e < token_elems; ++e)
+        errors += h_out[e] != 0.0f;
+    std::cout << "new sequence id " << fresh << ", sequence slots " << cache.sequence_slots()
+              << ", errors: " << errors << std::endl;
+    cache.free_sequence(fresh);
+
+    sycl::free(d_k, q);
+    sycl::free(d_v, q);
+    sycl::free(d_q, q);
+    sycl::free(d_out, q);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,307 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Keys:
+  1) property::queue::enable_profiling: events carry device timestamps, command_submit / command_start / command_end.
+  2) ScopedRegion: RAII host region, regions nest, every host thread has its own stack.
+  3) ProfiledQueue: wraps sycl::queue, every submit / parallel_for / memcpy is recorded with its name,
+     its host submit cost, its event, and optional bytes / FLOP counters.
+  4) Summary: per-kernel count, device time, queueing delay, GB/s and GFLOP/s.
+  5) Chrome trace: write_chrome_trace() produces JSON for chrome://tracing or https://ui.perfetto.dev
+
+Timeline of one kernel:
+
+  host:    |-- submit() --|                                  <- submission overhead (host clock)
+  device:         command_submit ....... command_start ===== command_end
+                                 queueing delay        kernel time
+
+  5_memcpy measures `now(); q.memcpy(...).wait(); now();`, which is submit + queueing + execution + wait
+  in a single number. Batching decisions need the three parts separately.
+
+Device timestamps use the device clock. They are mapped onto the host timeline with one offset,
+taken from the command with the largest (host submit - command_submit) difference, i.e. the smallest submit lag.
+Commands with a longer lag (the first kernel pays JIT compilation) then land later, never before their submit().
+*/
+
+struct Counters {
+    uint64_t bytes = 0;
+    uint64_t flops = 0;
+};
+
+class Profiler {
+public:
+    Profiler() : epoch_(std::chrono::steady_clock::now()) {}
+
+    // Nanoseconds on the host timeline.
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    void add_region(const std::string &name, uint64_t begin, uint64_t end, int depth) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        regions_.push_back({name, begin, end, depth, ThreadIndex()});
+    }
+
+    void add_command(const std::string &name, uint64_t host_begin, uint64_t host_end, sycl::event e, Counters c) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        commands_.push_back({name, host_begin, host_end, std::move(e), c, ThreadIndex()});
+    }
+
+    // Per-kernel aggregates.
+    void print_summary(std::ostream &os) {
+        struct Stats {
+            size_t count = 0;
+            double submit_us = 0, queued_us = 0, device_us = 0, max_device_us = 0;
+            Counters counters;
+        };
+        std::map<std::string, Stats> by_name;
+        for (auto &c : resolved()) {
+            Stats &s = by_name[c.name];
+            ++s.count;
+            s.submit_us += (c.host_end - c.host_begin) / 1e3;
+            s.queued_us += (c.start - c.submit) / 1e3;
+            s.device_us += (c.end - c.start) / 1e3;
+            s.max_device_us = std::max(s.max_device_us, (c.end - c.start) / 1e3);
+            s.counters.bytes += c.counters.bytes;
+            s.counters.flops += c.counters.flops;
+        }
+
+        os << std::left << std::setw(16) << "name" << std::right << std::setw(7) << "count" << std::setw(13)
+           << "submit(us)" << std::setw(13) << "queued(us)" << std::setw(13) << "device(us)" << std::setw(13)
+           << "max(us)" << std::setw(10) << "GB/s" << std::setw(10) << "GFLOP/s" << std::endl;
+        os << std::fixed << std::setprecision(1);
+        for (auto &[name, s] : by_name) {
+            os << std::left << std::setw(16) << name << std::right << std::setw(7) << s.count << std::setw(13)
+               << s.submit_us << std::setw(13) << s.queued_us << std::setw(13) << s.device_us << std::setw(13)
+               << s.max_device_us << std::setw(10) << s.counters.bytes / std::max(s.device_us, 1e-3) / 1e3
+               << std::setw(10) << s.counters.flops / std::max(s.device_us, 1e-3) / 1e3 << std::endl;
+        }
+        os << std::defaultfloat;
+    }
+
+    // Chrome trace event format, "X" (complete) events, ts / dur in usec.
+    //   pid 0: host threads, one tid per thread
+    //   pid 1: device, tid 0 = execution, tid 1 = queueing delay
+    void write_chrome_trace(const std::string &path) {
+        std::ofstream out(path);
+        out << "{\"traceEvents\":[\n";
+        out << R"({"name":"process_name","ph":"M","pid":0,"args":{"name":"host"}},)" << "\n";
+        out << R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"device"}},)" << "\n";
+        out << R"({"name":"thread_name","ph":"M","pid":1,"tid":0,"args":{"name":"execution"}},)" << "\n";
+        out << R"({"name":"thread_name","ph":"M","pid":1,"tid":1,"args":{"name":"queued"}})";
+
+        auto event = [&](const std::string &name, const char *cat, int pid, int tid, uint64_t begin, uint64_t end,
+                         const std::string &args) {
+            out << ",\n{\"name\":\"" << Escape(name) << "\",\"cat\":\"" << cat << "\",\"ph\":\"X\",\"pid\":" << pid
+                << ",\"tid\":" << tid << ",\"ts\":" << begin / 1e3 << ",\"dur\":" << (end - begin) / 1e3
+                << ",\"args\":{" << args << "}}";
+        };
+
+        std::lock_guard<std::mutex> lk(mutex_);
+        out << std::fixed << std::setprecision(3);
+        for (auto &r : regions_)
+            event(r.name, "host", 0, r.thread, r.begin, r.end, "\"depth\":" + std::to_string(r.depth));
+        for (auto &c : resolved_locked()) {
+            std::string args = "\"bytes\":" + std::to_string(c.counters.bytes) +
+                               ",\"flops\":" + std::to_string(c.counters.flops);
+            event(c.name, "submit", 0, c.thread, c.host_begin, c.host_end, args);
+            event(c.name, "queued", 1, 1, c.submit, c.start, args);
+            event(c.name, "kernel", 1, 0, c.start, c.end, args);
+        }
+        out << "\n]}\n";
+    }
+
+private:
+    struct Region {
+        std::string name;
+        uint64_t begin, end;
+        int depth;
+        int thread;
+    };
+
+    struct Command {
+        std::string name;
+        uint64_t host_begin, host_end;
+        sycl::event event;
+        Counters counters;
+        int thread;
+    };
+
+    // A command with its device timestamps mapped onto the host timeline.
+    struct Resolved {
+        std::string name;
+        uint64_t host_begin, host_end;
+        uint64_t submit, start, end;
+        Counters counters;
+        int thread;
+    };
+
+    static int ThreadIndex() {
+        static std::mutex m;
+        static std::map<std::thread::id, int> ids;
+        std::lock_guard<std::mutex> lk(m);
+        return ids.emplace(std::this_thread::get_id(), int(ids.size())).first->second;
+    }
+
+    static std::string Escape(const std::string &s) {
+        std::string r;
+        for (char ch : s) {
+            if (ch == '"' || ch == '\\')
+                r += '\\';
+            r += ch;
+        }
+        return r;
+    }
+
+    std::vector<Resolved> resolved() {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return resolved_locked();
+    }
+
+    std::vector<Resolved> resolved_locked() {
+        std::vector<Resolved> out;
+        int64_t offset = INT64_MIN;
+        for (auto &c : commands_) {
+            c.event.wait();
+            int64_t submit = c.event.get_profiling_info<sycl::info::event_profiling::command_submit>();
+            offset = std::max(offset, int64_t(c.host_begin) - submit);
+        }
+        for (auto &c : commands_) {
+            auto &e = c.event;
+            uint64_t submit = e.get_profiling_info<sycl::info::event_profiling::command_submit>() + offset;
+            uint64_t start = e.get_profiling_info<sycl::info::event_profiling::command_start>() + offset;
+            uint64_t end = e.get_profiling_info<sycl::info::event_profiling::command_end>() + offset;
+            // Some backends report command_submit slightly after command_start.
+            submit = std::min(submit, start);
+            out.push_back({c.name, c.host_begin, c.host_end, submit, start, end, c.counters, c.thread});
+        }
+        return out;
+    }
+
+    std::chrono::steady_clock::time_point epoch_;
+    std::mutex mutex_;
+    std::vector<Region> regions_;
+    std::vector<Command> commands_;
+};
+
+// Host region, records [construction, destruction) with its nesting depth on this thread.
+class ScopedRegion {
+public:
+    ScopedRegion(Profiler &prof, std::string name) : prof_(prof), name_(std::move(name)), begin_(prof.now()) {
+        depth_ = Depth()++;
+    }
+    ~ScopedRegion() {
+        --Depth();
+        prof_.add_region(name_, begin_, prof_.now(), depth_);
+    }
+
+    ScopedRegion(const ScopedRegion &) = delete;
+    ScopedRegion &operator=(const ScopedRegion &) = delete;
+
+private:
+    static int &Depth() {
+        thread_local int depth = 0;
+        return depth;
+    }
+
+    Profiler &prof_;
+    std::string name_;
+    uint64_t begin_;
+    int depth_;
+};
+
+// In-order sycl::queue with profiling enabled, every command is recorded in the Profiler.
+class ProfiledQueue {
+public:
+    ProfiledQueue(Profiler &prof, const sycl::device &dev = sycl::device(sycl::default_selector_v))
+        : prof_(prof),
+          q_(dev, sycl::property_list{sycl::property::queue::enable_profiling(), sycl::property::queue::in_order()}) {}
+
+    template <typename CGF>
+    sycl::event submit(const std::string &name, CGF &&cgf, Counters counters = {}) {
+        uint64_t begin = prof_.now();
+        sycl::event e = q_.submit(std::forward<CGF>(cgf));
+        prof_.add_command(name, begin, prof_.now(), e, counters);
+        return e;
+    }
+
+    template <typename Range, typename Kernel>
+    sycl::event parallel_for(const std::string &name, Range range, Kernel &&kernel, Counters counters = {}) {
+        return submit(name, [&](sycl::handler &h) { h.parallel_for(range, kernel); }, counters);
+    }
+
+    sycl::event memcpy(const std::string &name, void *dst, const void *src, size_t bytes) {
+        uint64_t begin = prof_.now();
+        sycl::event e = q_.memcpy(dst, src, bytes);
+        prof_.add_command(name, begin, prof_.now(), e, {bytes, 0});
+        return e;
+    }
+
+    void wait() { q_.wait(); }
+    sycl::queue &get() { return q_; }
+
+private:
+    Profiler &prof_;
+    sycl::queue q_;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example: the upload -> SiLU -> download steps of 5_memcpy / 6_exp_mul, fully instrumented.
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr size_t N = 1024 * 1024;
+constexpr int STEPS = 10;
+
+int main() {
+    Profiler prof;
+    ProfiledQueue pq(prof);
+    sycl::queue &q = pq.get();
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    float *data_cpu_pinned = sycl::malloc_host<float>(N, q);
+    float *data_gpu = sycl::malloc_device<float>(N, q);
+    float *out_gpu = sycl::malloc_device<float>(N, q);
+
+    {
+        ScopedRegion all(prof, "main loop");
+        for (int step = 0; step < STEPS; ++step) {
+            ScopedRegion region(prof, "step " + std::to_string(step));
+            {
+                ScopedRegion prepare(prof, "prepare input");
+                for (size_t i = 0; i < N; ++i)
+                    data_cpu_pinned[i] = 0.001f * float((i + step) % 1000);
+            }
+
+            pq.memcpy("h2d", data_gpu, data_cpu_pinned, N * sizeof(float));
+            pq.parallel_for("silu", sycl::range<1>(N), [=](sycl::id<1> i) {
+                out_gpu[i] = data_gpu[i] / (1.0f + sycl::exp(-data_gpu[i]));
+            }, {2 * N * sizeof(float), 4 * N});
+            pq.parallel_for("scale", sycl::range<1>(N), [=](sycl::id<1> i) {
+                out_gpu[i] *= 2.0f;
+            }, {2 * N * sizeof(float), N});
+            pq.memcpy("d2h", data_cpu_pinned, out_gpu, N * sizeof(float));
+
+            ScopedRegion wait(prof, "wait");
+            pq.wait();
+        }
+    }
+
+    prof.print_summary(std::cout);
+    prof.write_chrome_trace("trace.json");
+    std::cout << "Chrome trace written to trace.json (open in chrome://tracing or ui.perfetto.dev)" << std::endl;
+
+    sycl::free(data_cpu_pinned, q);
+    sycl::free(data_gpu, q);
+    sycl::free(out_gpu, q);
+    return 0;
+}
@@ -0,0 +1,329 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+/*
+Keys:
+  1) COO -> CSR -> sliced ELL (SELL-C) conversion on the host.
+  2) SpMV kernels:
+     • scalar CSR: one work-item per row, the naive kernel, one long row stalls its whole sub-group.
+     • vector CSR: one sub-group per row, lanes stride over the row, reduce_over_group(sub_group) sums it.
+     • binned CSR: rows are binned by length once on the host, short rows -> scalar kernel,
+       medium rows -> vector kernel, very long rows -> one work-group per row with reduce_over_group(group).
+     • SELL-C: C = 16 rows per slice, stored column-major inside the slice, so the 16 lanes of a sub-group
+       read 16 consecutive values (coalesced). Every slice is padded to its longest row.
+  3) SpMM: Y[rows][NRHS] = A * B[cols][NRHS] for a small dense right-hand side, one sub-group per row,
+     NRHS is a template parameter so the accumulators stay in registers.
+
+CSR:                                   SELL-C (C = 4 here), slice 0 = rows 0..3:
+  row_ptr: 0   2     5 6       9          col/val stored as  j=0: r0 r1 r2 r3 | j=1: r0 r1 r2 r3 | j=2: ...
+  col:     0 3 | 1 2 4 | 0 | 1 3 5        slice width = longest row in the slice, shorter rows padded with 0
+
+Power-law matrices (graphs, recommendation) have a few rows with thousands of entries and many rows with a
+handful. Scalar CSR load-imbalances on the long rows, vector CSR wastes 15 of 16 lanes on the short ones,
+binning gives each row length class the kernel shape that fits it.
+*/
+
+constexpr int SG = 16;       // sub-group size, also the SELL slice height
+constexpr int WG = 128;      // work-group size of the vector kernels
+constexpr int LONG_WG = 256; // work-group size for one very long row
+constexpr int SHORT_ROW = 8; // rows with <= SHORT_ROW entries go to the scalar kernel
+constexpr int LONG_ROW = 4096; // rows with > LONG_ROW entries get a whole work-group
+
+struct Coo {
+    int rows, cols;
+    std::vector<int> row, col;
+    std::vector<float> val;
+};
+
+struct HostCsr {
+    int rows, cols;
+    std::vector<int> row_ptr, col;
+    std::vector<float> val;
+};
+
+struct HostSell {
+    int rows, cols, slices;
+    std::vector<int> slice_ptr, col; // slice_ptr[s + 1] - slice_ptr[s] = SG * width of slice s
+    std::vector<float> val;
+};
+
+// Counting sort by row, the order inside a row is kept. Duplicates are kept, they add up in SpMV.
+HostCsr CooToCsr(const Coo &coo) {
+    HostCsr csr{coo.rows, coo.cols, std::vector<int>(coo.rows + 1, 0), std::vector<int>(coo.val.size()),
+                std::vector<float>(coo.val.size())};
+    for (int r : coo.row)
+        ++csr.row_ptr[r + 1];
+    std::partial_sum(csr.row_ptr.begin(), csr.row_ptr.end(), csr.row_ptr.begin());
+    std::vector<int> next(csr.row_ptr.begin(), csr.row_ptr.end() - 1);
+    for (size_t i = 0; i < coo.val.size(); ++i) {
+        int dst = next[coo.row[i]]++;
+        csr.col[dst] = coo.col[i];
+        csr.val[dst] = coo.val[i];
+    }
+    return csr;
+}
+
+HostSell CsrToSell(const HostCsr &csr) {
+    HostSell sell{csr.rows, csr.cols, (csr.rows + SG - 1) / SG, {0}, {}, {}};
+    for (int s = 0; s < sell.slices; ++s) {
+        int width = 0;
+        for (int r = s * SG; r < std::min(csr.rows, (s + 1) * SG); ++r)
+            width = std::max(width, csr.row_ptr[r + 1] - csr.row_ptr[r]);
+        sell.slice_ptr.push_back(sell.slice_ptr.back() + width * SG);
+    }
+    sell.col.assign(sell.slice_ptr.back(), 0);
+    sell.val.assign(sell.slice_ptr.back(), 0.0f);
+    for (int r = 0; r < csr.rows; ++r) {
+        int s = r / SG, lane = r % SG;
+        for (int j = 0; j < csr.row_ptr[r + 1] - csr.row_ptr[r]; ++j) {
+            int dst = sell.slice_ptr[s] + j * SG + lane;
+            sell.col[dst] = csr.col[csr.row_ptr[r] + j];
+            sell.val[dst] = csr.val[csr.row_ptr[r] + j];
+        }
+    }
+    return sell;
+}
+
+HostSell CooToSell(const Coo &coo) { return CsrToSell(CooToCsr(coo)); }
+
+// Device views, trivially copyable, captured by value in the kernels.
+struct Csr {
+    int rows, cols, nnz;
+    const int *row_ptr;
+    const int *col;
+    const float *val;
+};
+
+struct Sell {
+    int rows, cols, slices;
+    const int *slice_ptr;
+    const int *col;
+    const float *val;
+};
+
+// Row lists of the three length classes, device memory.
+struct Bins {
+    const int *rows[3];
+    int count[3];
+};
+
+template <typename T>
+T *Upload(sycl::queue &q, const std::vector<T> &v) {
+    T *d = sycl::malloc_device<T>(std::max<size_t>(v.size(), 1), q);
+    q.memcpy(d, v.data(), v.size() * sizeof(T)).wait();
+    return d;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Kernels, `rows` is an optional row list (nullptr = rows 0..count-1).
+// ---------------------------------------------------------------------------------------------------------------------
+sycl::event SpmvScalar(sycl::queue &q, Csr A, const int *rows, int count, const float *x, float *y) {
+    return q.parallel_for(sycl::range<1>(count), [=](sycl::id<1> i) {
+        const int r = rows ? rows[i] : int(i);
+        float sum = 0.0f;
+        for (int j = A.row_ptr[r]; j < A.row_ptr[r + 1]; ++j)
+            sum += A.val[j] * x[A.col[j]];
+        y[r] = sum;
+    });
+}
+
+sycl::event SpmvVector(sycl::queue &q, Csr A, const int *rows, int count, const float *x, float *y) {
+    constexpr int rows_per_wg = WG / SG;
+    const size_t wgs = (count + rows_per_wg - 1) / rows_per_wg;
+    return q.parallel_for(sycl::nd_range<1>(wgs * WG, WG), [=](sycl::nd_item<1> item) [[intel::reqd_sub_group_size(SG)]] {
+        auto sg = item.get_sub_group();
+        const int idx = item.get_group(0) * rows_per_wg + sg.get_group_linear_id();
+        if (idx >= count)
+            return;
+        const int r = rows ? rows[idx] : idx;
+        const int lane = sg.get_local_linear_id();
+        float sum = 0.0f;
+        for (int j = A.row_ptr[r] + lane; j < A.row_ptr[r + 1]; j += SG)
+            sum += A.val[j] * x[A.col[j]];
+        sum = sycl::reduce_over_group(sg, sum, sycl::plus<float>());
+        if (lane == 0)
+            y[r] = sum;
+    });
+}
+
+sycl::event SpmvWorkGroup(sycl::queue &q, Csr A, const int *rows, int count, const float *x, float *y) {
+    return q.parallel_for(sycl::nd_range<1>(size_t(count) * LONG_WG, LONG_WG), [=](sycl::nd_item<1> item) {
+        const int r = rows ? rows[item.get_group(0)] : int(item.get_group(0));
+        const int lid = item.get_local_id(0);
+        float sum = 0.0f;
+        for (int j = A.row_ptr[r] + lid; j < A.row_ptr[r + 1]; j += LONG_WG)
+            sum += A.val[j] * x[A.col[j]];
+        sum = sycl::reduce_over_group(item.get_group(), sum, sycl::plus<float>());
+        if (lid == 0)
+            y[r] = sum;
+    });
+}
+
+// The three bins are independent, they run concurrently on an out-of-order queue.
+void SpmvBinned(sycl::queue &q, Csr A, const Bins &bins, const float *x, float *y) {
+    std::vector<sycl::event> events;
+    if (bins.count[0])
+        events.push_back(SpmvScalar(q, A, bins.rows[0], bins.count[0], x, y));
+    if (bins.count[1])
+        events.push_back(SpmvVector(q, A, bins.rows[1], bins.count[1], x, y));
+    if (bins.count[2])
+        events.push_back(SpmvWorkGroup(q, A, bins.rows[2], bins.count[2], x, y));
+    for (auto &e : events)
+        e.wait();
+}
+
+sycl::event SpmvSell(sycl::queue &q, Sell A, const float *x, float *y) {
+    return q.parallel_for(sycl::nd_range<1>(size_t(A.slices) * SG, SG), [=](sycl::nd_item<1> item) [[intel::reqd_sub_group_size(SG)]] {
+        const int s = item.get_group(0);
+        const int lane = item.get_local_id(0);
+        const int r = s * SG + lane;
+        float sum = 0.0f;
+        for (int idx = A.slice_ptr[s] + lane; idx < A.slice_ptr[s + 1]; idx += SG)
+            sum += A.val[idx] * x[A.col[idx]];
+        if (r < A.rows)
+            y[r] = sum;
+    });
+}
+
+// Y[rows][NRHS] = A * B[cols][NRHS], both dense row-major.
+template <int NRHS>
+sycl::event Spmm(sycl::queue &q, Csr A, const float *B, float *Y) {
+    constexpr int rows_per_wg = WG / SG;
+    const size_t wgs = (A.rows + rows_per_wg - 1) / rows_per_wg;
+    return q.parallel_for(sycl::nd_range<1>(wgs * WG, WG), [=](sycl::nd_item<1> item) [[intel::reqd_sub_group_size(SG)]] {
+        auto sg = item.get_sub_group();
+        const int r = item.get_group(0) * rows_per_wg + sg.get_group_linear_id();
+        if (r >= A.rows)
+            return;
+        const int lane = sg.get_local_linear_id();
+        float acc[NRHS] = {};
+        for (int j = A.row_ptr[r] + lane; j < A.row_ptr[r + 1]; j += SG) {
+            const float a = A.val[j];
+            const float *b = B + size_t(A.col[j]) * NRHS;
+            for (int c = 0; c < NRHS; ++c)
+                acc[c] += a * b[c];
+        }
+        for (int c = 0; c < NRHS; ++c) {
+            float v = sycl::reduce_over_group(sg, acc[c], sycl::plus<float>());
+            if (lane == 0)
+                Y[size_t(r) * NRHS + c] = v;
+        }
+    });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Row lengths follow a power law, 4 + 20000 / rank^0.9, ranks are shuffled over the rows.
+Coo PowerLawMatrix(int rows, int cols) {
+    Coo coo{rows, cols, {}, {}, {}};
+    uint32_t seed = 12345;
+    auto next = [&seed] { return seed = seed * 1664525u + 1013904223u; };
+    std::vector<int> rank(rows);
+    std::iota(rank.begin(), rank.end(), 1);
+    for (int i = rows - 1; i > 0; --i)
+        std::swap(rank[i], rank[next() % (i + 1)]);
+    for (int r = 0; r < rows; ++r) {
+        int len = std::min(cols, 4 + int(20000.0 / std::pow(double(rank[r]), 0.9)));
+        for (int j = 0; j < len; ++j) {
+            coo.row.push_back(r);
+            coo.col.push_back(int(next() % cols));
+            coo.val.push_back(float(next() % 1000) / 1000.0f - 0.5f);
+        }
+    }
+    return coo;
+}
+
+template <typename Fn>
+double TimeUs(Fn &&fn, int iters = 10) {
+    fn();
+    auto tag_0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+        fn();
+    auto tag_1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(tag_1 - tag_0).count() / iters;
+}
+
+int Check(const std::vector<double> &ref, const std::vector<float> &out) {
+    int errors = 0;
+    for (size_t i = 0; i < ref.size(); ++i)
+        if (std::abs(ref[i] - out[i]) > 1e-3 * (1.0 + std::abs(ref[i])))
+            ++errors;
+    return errors;
+}
+
+int main() {
+    sycl::queue q;
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    constexpr int ROWS = 1 << 18, COLS = 1 << 18, NRHS = 8;
+    Coo coo = PowerLawMatrix(ROWS, COLS);
+    HostCsr csr = CooToCsr(coo);
+    HostSell sell = CsrToSell(csr);
+
+    int max_row = 0;
+    std::vector<int> bin_rows[3];
+    for (int r = 0; r < ROWS; ++r) {
+        int len = csr.row_ptr[r + 1] - csr.row_ptr[r];
+        max_row = std::max(max_row, len);
+        bin_rows[len <= SHORT_ROW ? 0 : len <= LONG_ROW ? 1 : 2].push_back(r);
+    }
+    std::cout << "rows: " << ROWS << ", nnz: " << csr.val.size() << ", longest row: " << max_row
+              << ", bins (short/medium/long): " << bin_rows[0].size() << "/" << bin_rows[1].size() << "/"
+              << bin_rows[2].size() << ", SELL padding: " << double(sell.val.size()) / csr.val.size() << "x" << std::endl;
+
+    std::vector<float> x(COLS), B(size_t(COLS) * NRHS);
+    for (int i = 0; i < COLS; ++i)
+        x[i] = std::sin(0.01f * i);
+    for (size_t i = 0; i < B.size(); ++i)
+        B[i] = std::cos(0.003f * float(i));
+
+    std::vector<double> ref(ROWS, 0.0), ref_mm(size_t(ROWS) * NRHS, 0.0);
+    for (int r = 0; r < ROWS; ++r) {
+        for (int j = csr.row_ptr[r]; j < csr.row_ptr[r + 1]; ++j) {
+            ref[r] += double(csr.val[j]) * x[csr.col[j]];
+            for (int c = 0; c < NRHS; ++c)
+                ref_mm[size_t(r) * NRHS + c] += double(csr.val[j]) * B[size_t(csr.col[j]) * NRHS + c];
+        }
+    }
+
+    Csr A{ROWS, COLS, int(csr.val.size()), Upload(q, csr.row_ptr), Upload(q, csr.col), Upload(q, csr.val)};
+    Sell S{ROWS, COLS, sell.slices, Upload(q, sell.slice_ptr), Upload(q, sell.col), Upload(q, sell.val)};
+    Bins bins{{Upload(q, bin_rows[0]), Upload(q, bin_rows[1]), Upload(q, bin_rows[2])},
+              {int(bin_rows[0].size()), int(bin_rows[1].size()), int(bin_rows[2].size())}};
+    float *d_x = Upload(q, x);
+    float *d_B = Upload(q, B);
+    float *d_y = sycl::malloc_device<float>(size_t(ROWS) * NRHS, q);
+    std::vector<float> y(ROWS), y_mm(size_t(ROWS) * NRHS);
+
+    auto report = [&](const char *name, double us) {
+        q.memcpy(y.data(), d_y, ROWS * sizeof(float)).wait();
+        std::cout << name << us << " usec, " << 2.0 * A.nnz / us / 1e3 << " GFLOP/s, errors: " << Check(ref, y) << std::endl;
+    };
+
+    report("SpMV scalar CSR: ", TimeUs([&] { SpmvScalar(q, A, nullptr, ROWS, d_x, d_y).wait(); }));
+    report("SpMV vector CSR: ", TimeUs([&] { SpmvVector(q, A, nullptr, ROWS, d_x, d_y).wait(); }));
+    report("SpMV binned CSR: ", TimeUs([&] { SpmvBinned(q, A, bins, d_x, d_y); }));
+    report("SpMV SELL-16:    ", TimeUs([&] { SpmvSell(q, S, d_x, d_y).wait(); }));
+
+    double us = TimeUs([&] { Spmm<NRHS>(q, A, d_B, d_y).wait(); });
+    q.memcpy(y_mm.data(), d_y, y_mm.size() * sizeof(float)).wait();
+    std::cout << "SpMM (NRHS=" << NRHS << "):   " << us << " usec, " << 2.0 * A.nnz * NRHS / us / 1e3
+              << " GFLOP/s, errors: " << Check(ref_mm, y_mm) << std::endl;
+
+    for (const void *p : {(const void *)A.row_ptr, (const void *)A.col, (const void *)A.val, (const void *)S.slice_ptr,
+                          (const void *)S.col, (const void *)S.val, (const void *)bins.rows[0],
+                          (const void *)bins.rows[1], (const void *)bins.rows[2]})
+        sycl::free(const_cast<void *>(p), q);
+    sycl::free(d_x, q);
+    sycl::free(d_B, q);
+    sycl::free(d_y, q);
+    return 0;
+}
@@ -0,0 +1,313 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+Keys:
+  1) Tensor<T, Rank>: owning device allocation with dtype, shape and strides, the rank is a template parameter.
+     The allocation is 64-byte aligned, every innermost row is padded to a multiple of 64 bytes (the pitch).
+  2) TensorView<T, Rank>: non-owning pointer + shape + strides, trivially copyable, captured by value in kernels.
+     view(i, j, k) replaces hand-written index math like
+        linearIndex = get_global_id(0) * get_global_range(1) * get_global_range(2) + ...   (4_subgroup addKernel)
+  3) slice(dim, begin, end) and select(dim, i) are O(1), they only change the pointer / shape / strides.
+  4) Upload / Download pack and unpack the padding on the host, so one memcpy moves the whole tensor.
+  5) A const Tensor only hands out TensorView<const T, Rank>.
+
+Out of scope: structure-of-arrays containers. A Tensor holds one dtype; a record type is stored as one Tensor per field,
+each with its own padded layout.
+
+Layout of a Tensor<float, 2> with shape {3, 20}: pitch = 32 floats (128 bytes), every row starts 64-byte aligned.
+
+  row 0: | 20 values ............................. | 12 padding |
+  row 1: | 20 values ............................. | 12 padding |
+  row 2: | 20 values ............................. | 12 padding |
+          ^ 64-byte aligned                                     ^ strides = {32, 1}
+
+Why:
+  • A sycl::vec<float, 4> load needs a 16-byte aligned address. With an unpadded row of 1000 floats, row 1 starts at
+    byte 4000, which is fine, but with 1001 floats it starts at byte 4004 and every vector load of that row is misaligned.
+  • Padding also keeps every row on its own cache lines, so a sub-group reading one row never touches the previous one.
+  • Kernels may read (and write) the padding of a row, it is zero after Upload and never copied back.
+*/
+
+constexpr size_t TENSOR_ALIGN = 64; // bytes, alignment of the allocation and of every row
+
+enum class DType { F32, I32, U8 };
+
+template <typename T> struct DTypeOf;
+template <> struct DTypeOf<float> { static constexpr DType value = DType::F32; };
+template <> struct DTypeOf<int32_t> { static constexpr DType value = DType::I32; };
+template <> struct DTypeOf<uint8_t> { static constexpr DType value = DType::U8; };
+
+inline const char *DTypeName(DType d) {
+    switch (d) {
+    case DType::F32: return "f32";
+    case DType::I32: return "i32";
+    default: return "u8";
+    }
+}
+
+template <typename T, int Rank>
+struct TensorView {
+    static_assert(Rank >= 1, "rank must be at least 1");
+    static constexpr DType dtype = DTypeOf<std::remove_const_t<T>>::value;
+
+    T *data;
+    size_t shape[Rank];
+    size_t strides[Rank]; // in elements
+
+    template <typename... I>
+    T &operator()(I... idx) const {
+        static_assert(sizeof...(I) == Rank, "wrong number of indices");
+        const size_t ids[Rank] = {size_t(idx)...};
+        size_t offset = 0;
+        for (int d = 0; d < Rank; ++d)
+            offset += ids[d] * strides[d];
+        return data[offset];
+    }
+
+    // Pointer to the innermost row at the given outer indices, padded rows can be read with vector loads.
+    template <typename... I>
+    T *row(I... idx) const {
+        static_assert(sizeof...(I) == Rank - 1, "row() takes Rank - 1 indices");
+        const size_t ids[Rank] = {size_t(idx)..., 0};
+        size_t offset = 0;
+        for (int d = 0; d < Rank - 1; ++d)
+            offset += ids[d] * strides[d];
+        return data + offset;
+    }
+
+    size_t size() const {
+        size_t n = 1;
+        for (int d = 0; d < Rank; ++d)
+            n *= shape[d];
+        return n;
+    }
+
+    // Elements between two rows, >= shape[Rank - 1].
+    size_t pitch() const { return Rank == 1 ? shape[0] : strides[Rank - 2]; }
+
+    TensorView slice(int dim, size_t begin, size_t end) const {
+        TensorView v = *this;
+        v.data = data + begin * strides[dim];
+        v.shape[dim] = end - begin;
+        return v;
+    }
+
+    TensorView<T, (Rank > 1 ? Rank - 1 : 1)> select(int dim, size_t i) const {
+        static_assert(Rank > 1, "select() on a rank-1 view");
+        TensorView<T, (Rank > 1 ? Rank - 1 : 1)> v{data + i * strides[dim], {}, {}};
+        for (int d = 0, o = 0; d < Rank; ++d) {
+            if (d == dim)
+                continue;
+            v.shape[o] = shape[d];
+            v.strides[o++] = strides[d];
+        }
+        return v;
+    }
+
+    operator TensorView<const T, Rank>() const {
+        TensorView<const T, Rank> v{data, {}, {}};
+        for (int d = 0; d < Rank; ++d) {
+            v.shape[d] = shape[d];
+            v.strides[d] = strides[d];
+        }
+        return v;
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<TensorView<float, 3>>, "views are passed to kernels by value");
+
+template <typename T, int Rank>
+class Tensor {
+public:
+    static constexpr DType dtype = DTypeOf<T>::value;
+
+    // padded = false gives the dense layout (pitch = shape[Rank - 1]), still 64-byte aligned.
+    Tensor(sycl::queue &q, const std::array<size_t, Rank> &shape, bool padded = true) : q_(&q) {
+        constexpr size_t row_align = TENSOR_ALIGN / sizeof(T);
+        size_t stride = 1;
+        for (int d = Rank - 1; d >= 0; --d) {
+            view_.shape[d] = shape[d];
+            view_.strides[d] = stride;
+            stride *= d == Rank - 1 && padded ? (shape[d] + row_align - 1) / row_align * row_align : shape[d];
+        }
+        elements_ = stride;
+        view_.data = sycl::aligned_alloc_device<T>(TENSOR_ALIGN, std::max<size_t>(elements_, 1), q);
+        if (!view_.data)
+            throw std::runtime_error("Tensor: device allocation failed");
+        q.memset(view_.data, 0, elements_ * sizeof(T)).wait();
+    }
+
+    ~Tensor() {
+        if (view_.data)
+            sycl::free(view_.data, *q_);
+    }
+
+    Tensor(Tensor &&other) noexcept : q_(other.q_), view_(other.view_), elements_(other.elements_) {
+        other.view_.data = nullptr;
+    }
+    Tensor(const Tensor &) = delete;
+    Tensor &operator=(const Tensor &) = delete;
+
+    TensorView<T, Rank> view() { return view_; }
+    TensorView<const T, Rank> view() const { return view_; }
+    const size_t *shape() const { return view_.shape; }
+    size_t size() const { return view_.size(); }
+    size_t bytes() const { return elements_ * sizeof(T); } // including the padding
+
+    // Blocking, `src` is dense row-major, the host side inserts the row padding, then one memcpy.
+    void upload(const std::vector<T> &src) {
+        check_size(src.size());
+        if (dense()) {
+            q_->memcpy(view_.data, src.data(), src.size() * sizeof(T)).wait();
+            return;
+        }
+        staging_.assign(elements_, T{});
+        const size_t cols = view_.shape[Rank - 1], pitch = view_.pitch();
+        for (size_t r = 0; r < src.size() / cols; ++r)
+            std::memcpy(staging_.data() + r * pitch, src.data() + r * cols, cols * sizeof(T));
+        q_->memcpy(view_.data, staging_.data(), elements_ * sizeof(T)).wait();
+    }
+
+    // Blocking, `dst` receives the dense row-major values.
+    void download(std::vector<T> &dst) {
+        dst.resize(size());
+        if (dense()) {
+            q_->memcpy(dst.data(), view_.data, dst.size() * sizeof(T)).wait();
+            return;
+        }
+        staging_.resize(elements_);
+        q_->memcpy(staging_.data(), view_.data, elements_ * sizeof(T)).wait();
+        const size_t cols = view_.shape[Rank - 1], pitch = view_.pitch();
+        for (size_t r = 0; r < dst.size() / cols; ++r)
+            std::memcpy(dst.data() + r * cols, staging_.data() + r * pitch, cols * sizeof(T));
+    }
+
+private:
+    bool dense() const { return view_.pitch() == view_.shape[Rank - 1]; }
+
+    void check_size(size_t n) const {
+        if (n != size())
+            throw std::invalid_argument("Tensor: host data has " + std::to_string(n) + " elements, tensor has " +
+                                        std::to_string(size()));
+    }
+
+    sycl::queue *q_;
+    TensorView<T, Rank> view_{};
+    size_t elements_ = 0;
+    std::vector<T> staging_;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------------------------------------------------
+
+// 4_subgroup's Add with a rank-3 view instead of the linear index.
+void Add3D(sycl::queue &q, TensorView<const int32_t, 3> a, TensorView<const int32_t, 3> b, TensorView<int32_t, 3> c) {
+    q.parallel_for(sycl::range<3>(c.shape[0], c.shape[1], c.shape[2]), [=](sycl::item<3> it) {
+        c(it[0], it[1], it[2]) = a(it[0], it[1], it[2]) + b(it[0], it[1], it[2]);
+    }).wait();
+}
+
+inline bool Aligned16(const void *p) { return reinterpret_cast<uintptr_t>(p) % 16 == 0; }
+
+// y = x * scale + bias per row. Vector path: one work-item per 4 values, sycl::vec<float, 4> loads and stores,
+// padding lanes are computed too. It is taken only when x and y share a pitch that is a multiple of 4, `bias` holds
+// at least `pitch` values and all three are 16-byte aligned. Otherwise: one work-item per value, scalar loads.
+sycl::event ScaleBias(sycl::queue &q, TensorView<const float, 2> x, TensorView<const float, 1> bias, float scale,
+                      TensorView<float, 2> y) {
+    const size_t rows = x.shape[0], pitch = x.pitch();
+    const bool vectorizable = pitch % 4 == 0 && y.pitch() == pitch && bias.shape[0] >= pitch && Aligned16(x.data) &&
+                              Aligned16(y.data) && Aligned16(bias.data);
+    if (vectorizable) {
+        return q.parallel_for(sycl::range<2>(rows, pitch / 4), [=](sycl::item<2> it) {
+            const size_t c = it[1] * 4;
+            auto xv = *reinterpret_cast<const sycl::vec<float, 4> *>(x.row(it[0]) + c);
+            auto bv = *reinterpret_cast<const sycl::vec<float, 4> *>(bias.data + c);
+            *reinterpret_cast<sycl::vec<float, 4> *>(y.row(it[0]) + c) = xv * scale + bv;
+        });
+    }
+    return q.parallel_for(sycl::range<2>(rows, x.shape[1]), [=](sycl::item<2> it) {
+        y(it[0], it[1]) = x(it[0], it[1]) * scale + bias(it[1]);
+    });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example
+// ---------------------------------------------------------------------------------------------------------------------
+template <typename Fn>
+double TimeUs(Fn &&fn, int iters = 20) {
+    fn();
+    auto tag_0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+        fn();
+    auto tag_1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(tag_1 - tag_0).count() / iters;
+}
+
+int main() {
+    sycl::queue q;
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    // Rank-3 add, same shape as 4_subgroup.
+    {
+        constexpr size_t S = 4, H = 4, D = 2;
+        std::vector<int32_t> a(S * H * D), b(S * H * D), c;
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = int32_t(i);
+            b[i] = int32_t(100 * i);
+        }
+        Tensor<int32_t, 3> ta(q, {S, H, D}), tb(q, {S, H, D}), tc(q, {S, H, D});
+        ta.upload(a);
+        tb.upload(b);
+        Add3D(q, ta.view(), tb.view(), tc.view());
+        tc.download(c);
+        int errors = 0;
+        for (size_t i = 0; i < c.size(); ++i)
+            errors += c[i] != a[i] + b[i];
+        std::cout << "Add3D " << DTypeName(tc.dtype) << " {" << S << ", " << H << ", " << D << "}, pitch "
+                  << tc.view().pitch() << ", errors: " << errors << std::endl;
+    }
+
+    // Padded vs dense rows with an odd width.
+    constexpr size_t ROWS = 8192, COLS = 1001;
+    std::vector<float> x(ROWS * COLS), bias(COLS), y;
+    for (size_t i = 0; i < x.size(); ++i)
+        x[i] = std::sin(0.001f * float(i % 10007));
+    for (size_t i = 0; i < COLS; ++i)
+        bias[i] = 0.01f * float(i);
+
+    for (bool padded : {false, true}) {
+        Tensor<float, 2> tx(q, {ROWS, COLS}, padded), ty(q, {ROWS, COLS}, padded);
+        tx.upload(x);
+        // The vector path reads `pitch` bias values per row, the extra ones are zero.
+        std::vector<float> padded_bias(tx.view().pitch(), 0.0f);
+        std::copy(bias.begin(), bias.end(), padded_bias.begin());
+        Tensor<float, 1> tbias(q, {padded_bias.size()}, false);
+        tbias.upload(padded_bias);
+        double us = TimeUs([&] { ScaleBias(q, tx.view(), tbias.view(), 2.0f, ty.view()).wait(); });
+        ty.download(y);
+
+        int errors = 0;
+        for (size_t r = 0; r < ROWS; ++r)
+            for (size_t c = 0; c < COLS; ++c)
+                errors += std::abs(y[r * COLS + c] - (x[r * COLS + c] * 2.0f + bias[c])) > 1e-5f;
+
+        // A slice of rows 100..199 is a view into the same allocation, no copy.
+        auto rows = tx.view().slice(0, 100, 200);
+        std::cout << (padded ? "padded" : "dense ") << " pitch " << tx.view().pitch() << ": " << us << " usec, "
+                  << 2.0 * ROWS * COLS * sizeof(float) / us / 1e3 << " GB/s, errors: " << errors
+                  << ", slice [100, 200) starts at row " << (rows.data - tx.view().data) / tx.view().pitch() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,316 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+Keys:
+  1) Binner: maps one input value to a bin index, -1 drops the value.
+     IdentityBins (integer bincount), LinearBins and Log2Bins (float values, out of range values go to the edge bins).
+  2) Four kernels, all add into one global uint64_t histogram:
+     • Global:    one device-scope atomic_ref::fetch_add per element, the baseline.
+     • Local:     every work-group keeps a private histogram in local_accessor memory, updated with
+                  work_group-scope atomic_ref, merged with one global atomic per non-empty bin per work-group.
+     • SubGroup:  bins <= SG_BINS, every lane counts in registers, the lane counts are summed with
+                  reduce_over_group(sub_group), one local atomic per bin per sub-group.
+     • MultiPass: bins do not fit into local memory, the Local kernel runs once per window of bins,
+                  every pass reads the whole input and only counts its own window.
+  3) Histogram() picks the path from the bin count and the local memory size.
+
+Why:
+  Token ids and latencies are skewed, most elements hit a handful of bins. With global atomics every one of them
+  serializes on the same cache line. A local histogram moves the contention into local memory (much cheaper),
+  and the global histogram only sees (work-groups x bins) atomics instead of one per element.
+
+  element -> binner -> local[b] += 1 (work_group scope)   ...   barrier   ...   hist[b] += local[b] (device scope)
+*/
+
+constexpr int WG = 256;     // work-group size
+constexpr int SG = 16;      // sub-group size
+constexpr int SG_BINS = 16; // max bins of the sub-group path
+
+template <typename T>
+struct IdentityBins {
+    int bins;
+    int operator()(T v) const {
+        if constexpr (std::is_unsigned_v<T>)
+            return uint64_t(v) < uint64_t(bins) ? int(v) : -1;
+        else
+            return v >= 0 && int64_t(v) < bins ? int(v) : -1;
+    }
+};
+
+struct LinearBins {
+    float lo, hi;
+    int bins;
+    int operator()(float v) const {
+        if (!(v > lo)) // also catches NaN
+            return 0;
+        if (!(v < hi))
+            return bins - 1;
+        return std::min(int((v - lo) * (float(bins) / (hi - lo))), bins - 1);
+    }
+};
+
+// Bins of equal width in log2(v), for latencies spanning several orders of magnitude.
+struct Log2Bins {
+    float lo, hi; // in log2 units
+    int bins;
+    int operator()(float v) const { return LinearBins{lo, hi, bins}(v > 0.0f ? sycl::log2(v) : lo); }
+};
+
+enum class HistPath { Global, Local, SubGroup, MultiPass };
+
+const char *PathName(HistPath p) {
+    switch (p) {
+    case HistPath::Global: return "global atomics";
+    case HistPath::Local: return "local privatized";
+    case HistPath::SubGroup: return "sub-group aggregated";
+    default: return "multi-pass local";
+    }
+}
+
+size_t NumGroups(sycl::queue &q) {
+    return size_t(q.get_device().get_info<sycl::info::device::max_compute_units>()) * 4;
+}
+
+// Bins of uint32_t that fit into local memory, half of it is left for the runtime / other kernels.
+int LocalBinCapacity(sycl::queue &q) {
+    return int(q.get_device().get_info<sycl::info::device::local_mem_size>() / 2 / sizeof(uint32_t));
+}
+
+using GlobalCounter = sycl::atomic_ref<uint64_t, sycl::memory_order::relaxed, sycl::memory_scope::device,
+                                       sycl::access::address_space::global_space>;
+using LocalCounter = sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::work_group,
+                                      sycl::access::address_space::local_space>;
+
+template <typename T, typename Binner>
+sycl::event HistogramGlobal(sycl::queue &q, const T *in, size_t n, Binner binner, uint64_t *hist) {
+    return q.parallel_for(sycl::range<1>(n), [=](sycl::id<1> i) {
+        const int b = binner(in[i]);
+        if (b >= 0)
+            GlobalCounter(hist[b]).fetch_add(1);
+    });
+}
+
+// Counts only the bins [bin_begin, bin_begin + bin_count), the multi-pass path calls it once per window.
+template <typename T, typename Binner>
+sycl::event HistogramLocal(sycl::queue &q, const T *in, size_t n, Binner binner, int bin_begin, int bin_count,
+                           uint64_t *hist) {
+    const size_t groups = NumGroups(q);
+    return q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<uint32_t, 1> local(sycl::range<1>(bin_count), h);
+        h.parallel_for(sycl::nd_range<1>(groups * WG, WG), [=](sycl::nd_item<1> item) {
+            const int lid = item.get_local_id(0);
+            for (int b = lid; b < bin_count; b += WG)
+                local[b] = 0;
+            sycl::group_barrier(item.get_group());
+
+            for (size_t i = item.get_global_id(0); i < n; i += item.get_global_range(0)) {
+                const int b = binner(in[i]) - bin_begin;
+                if (b >= 0 && b < bin_count)
+                    LocalCounter(local[b]).fetch_add(1u);
+            }
+            sycl::group_barrier(item.get_group());
+
+            for (int b = lid; b < bin_count; b += WG)
+                if (local[b])
+                    GlobalCounter(hist[bin_begin + b]).fetch_add(uint64_t(local[b]));
+        });
+    });
+}
+
+template <typename T, typename Binner>
+sycl::event HistogramSubGroup(sycl::queue &q, const T *in, size_t n, Binner binner, uint64_t *hist) {
+    const size_t groups = NumGroups(q);
+    const int bins = binner.bins;
+    return q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<uint32_t, 1> local(sycl::range<1>(SG_BINS), h);
+        h.parallel_for(sycl::nd_range<1>(groups * WG, WG), [=](sycl::nd_item<1> item) [[intel::reqd_sub_group_size(SG)]] {
+            auto sg = item.get_sub_group();
+            const int lid = item.get_local_id(0);
+            if (lid < SG_BINS)
+                local[lid] = 0;
+
+            // Constant indices only, so `count` stays in registers.
+            uint32_t count[SG_BINS] = {};
+            for (size_t i = item.get_global_id(0); i < n; i += item.get_global_range(0)) {
+                const int b = binner(in[i]);
+                for (int k = 0; k < SG_BINS; ++k)
+                    count[k] += b == k;
+            }
+            sycl::group_barrier(item.get_group());
+
+            for (int k = 0; k < bins; ++k) {
+                const uint32_t c = sycl::reduce_over_group(sg, count[k], sycl::plus<uint32_t>());
+                if (sg.get_local_linear_id() == 0 && c)
+                    LocalCounter(local[k]).fetch_add(c);
+            }
+            sycl::group_barrier(item.get_group());
+
+            if (lid < bins && local[lid])
+                GlobalCounter(hist[lid]).fetch_add(uint64_t(local[lid]));
+        });
+    });
+}
+
+template <typename Binner>
+HistPath ChoosePath(sycl::queue &q, const Binner &binner) {
+    if (binner.bins <= SG_BINS)
+        return HistPath::SubGroup;
+    return binner.bins <= LocalBinCapacity(q) ? HistPath::Local : HistPath::MultiPass;
+}
+
+// hist[binner.bins] is overwritten with the counts of in[0, n). Blocking.
+template <typename T, typename Binner>
+void Histogram(sycl::queue &q, const T *in, size_t n, Binner binner, uint64_t *hist, HistPath path) {
+    q.memset(hist, 0, binner.bins * sizeof(uint64_t)).wait();
+    switch (path) {
+    case HistPath::Global: HistogramGlobal(q, in, n, binner, hist).wait(); break;
+    case HistPath::SubGroup: HistogramSubGroup(q, in, n, binner, hist).wait(); break;
+    case HistPath::Local: HistogramLocal(q, in, n, binner, 0, binner.bins, hist).wait(); break;
+    case HistPath::MultiPass: {
+        // The windows write disjoint bins, so the passes may run concurrently.
+        const int window = LocalBinCapacity(q);
+        std::vector<sycl::event> passes;
+        for (int begin = 0; begin < binner.bins; begin += window)
+            passes.push_back(HistogramLocal(q, in, n, binner, begin, std::min(window, binner.bins - begin), hist));
+        for (auto &e : passes)
+            e.wait();
+        break;
+    }
+    }
+}
+
+template <typename T, typename Binner>
+void Histogram(sycl::queue &q, const T *in, size_t n, Binner binner, uint64_t *hist) {
+    Histogram(q, in, n, binner, hist, ChoosePath(q, binner));
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example: token-frequency, latency and status-code histograms, every path against a reference count.
+// ---------------------------------------------------------------------------------------------------------------------
+// Reference: the bin of every element is computed on the device with the same binner, so values within an ulp of a
+// bin edge (sycl::log2 vs. std::log2) land in the same bin as in the kernels under test, and counted on the host.
+template <typename T, typename Binner>
+std::vector<uint64_t> Reference(sycl::queue &q, const T *in, size_t n, Binner binner) {
+    int *d_bins = sycl::malloc_device<int>(n, q);
+    q.parallel_for(sycl::range<1>(n), [=](sycl::id<1> i) { d_bins[i] = binner(in[i]); }).wait();
+    std::vector<int> bins(n);
+    q.memcpy(bins.data(), d_bins, n * sizeof(int)).wait();
+    sycl::free(d_bins, q);
+
+    std::vector<uint64_t> ref(binner.bins, 0);
+    for (int b : bins)
+        if (b >= 0)
+            ++ref[b];
+    return ref;
+}
+
+// The binners evaluated on the device against bins worked out by hand, Reference() can not catch a wrong binner.
+template <typename T, typename Binner>
+int CheckBinner(sycl::queue &q, Binner binner, const std::vector<std::pair<T, int>> &cases) {
+    const size_t n = cases.size();
+    T *d_in = sycl::malloc_device<T>(n, q);
+    int *d_bins = sycl::malloc_device<int>(n, q);
+    std::vector<T> values(n);
+    std::vector<int> bins(n);
+    for (size_t i = 0; i < n; ++i)
+        values[i] = cases[i].first;
+    q.memcpy(d_in, values.data(), n * sizeof(T)).wait();
+    q.parallel_for(sycl::range<1>(n), [=](sycl::id<1> i) { d_bins[i] = binner(d_in[i]); }).wait();
+    q.memcpy(bins.data(), d_bins, n * sizeof(int)).wait();
+    sycl::free(d_in, q);
+    sycl::free(d_bins, q);
+
+    int errors = 0;
+    for (size_t i = 0; i < n; ++i)
+        errors += bins[i] != cases[i].second;
+    return errors;
+}
+
+template <typename T, typename Binner>
+void Run(sycl::queue &q, const char *name, const std::vector<T> &data, Binner binner) {
+    std::vector<uint64_t> out(binner.bins);
+    T *d_in = sycl::malloc_device<T>(data.size(), q);
+    uint64_t *d_hist = sycl::malloc_device<uint64_t>(binner.bins, q);
+    q.memcpy(d_in, data.data(), data.size() * sizeof(T)).wait();
+    const std::vector<uint64_t> ref = Reference(q, d_in, data.size(), binner);
+
+    const HistPath best = ChoosePath(q, binner);
+    std::cout << name << ": " << data.size() << " events, " << binner.bins << " bins" << std::endl;
+    for (HistPath path : {HistPath::Global, best}) {
+        Histogram(q, d_in, data.size(), binner, d_hist, path);
+        auto tag_0 = std::chrono::high_resolution_clock::now();
+        Histogram(q, d_in, data.size(), binner, d_hist, path);
+        auto tag_1 = std::chrono::high_resolution_clock::now();
+        double us = std::chrono::duration<double, std::micro>(tag_1 - tag_0).count();
+
+        q.memcpy(out.data(), d_hist, binner.bins * sizeof(uint64_t)).wait();
+        int errors = 0;
+        for (int b = 0; b < binner.bins; ++b)
+            errors += out[b] != ref[b];
+        std::cout << "  " << PathName(path) << ": " << us << " usec, " << data.size() / us / 1e3
+                  << " Gevents/s, errors: " << errors << std::endl;
+    }
+
+    sycl::free(d_in, q);
+    sycl::free(d_hist, q);
+}
+
+int main() {
+    sycl::queue q;
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << ", local bins: "
+              << LocalBinCapacity(q) << std::endl;
+    if (!q.get_device().has(sycl::aspect::atomic64)) {
+        std::cout << "64-bit atomics are not supported, skipping." << std::endl;
+        return 0;
+    }
+
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        int errors = CheckBinner<int32_t>(q, IdentityBins<int32_t>{10}, {{-1, -1}, {0, 0}, {9, 9}, {10, -1}});
+        errors += CheckBinner<uint8_t>(q, IdentityBins<uint8_t>{12}, {{0, 0}, {11, 11}, {12, -1}, {255, -1}});
+        errors += CheckBinner<float>(q, LinearBins{0.0f, 1.0f, 4}, {{nan, 0}, {-1.0f, 0}, {0.3f, 1}, {0.99f, 3}, {2.0f, 3}});
+        // log2: 1 -> 0, 1024 -> 10 * 64 / 20 = 32, 2^20 and above -> last bin.
+        errors += CheckBinner<float>(q, Log2Bins{0.0f, 20.0f, 64}, {{0.0f, 0}, {1.0f, 0}, {1024.0f, 32}, {3e6f, 63}});
+        std::cout << "binner checks, errors: " << errors << std::endl;
+    }
+
+    constexpr size_t N = 1 << 25;
+    constexpr int VOCAB = 32000;
+    uint32_t seed = 2024;
+    auto uniform = [&seed] {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1 << 24);
+    };
+
+    {
+        // Skewed towards small ids, like token frequencies.
+        std::vector<int32_t> tokens(N);
+        for (auto &t : tokens)
+            t = std::min(VOCAB - 1, int(VOCAB * std::pow(uniform(), 4.0f)));
+        Run(q, "tokens", tokens, IdentityBins<int32_t>{VOCAB});
+    }
+    {
+        // Latencies in usec, roughly log-normal around 100 usec, 1 usec .. 1 sec in 64 log bins.
+        std::vector<float> latency(N);
+        for (auto &l : latency)
+            l = 100.0f * std::exp(2.0f * (uniform() + uniform() + uniform() - 1.5f));
+        Run(q, "latency", latency, Log2Bins{0.0f, 20.0f, 64});
+    }
+    {
+        // Few distinct values, almost all of them 0.
+        std::vector<uint8_t> status(N);
+        for (auto &s : status)
+            s = uniform() < 0.95f ? 0 : uint8_t(1 + int(uniform() * 11));
+        Run(q, "status", status, IdentityBins<uint8_t>{12});
+    }
+    return 0;
+}
@@ -0,0 +1,460 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/*
+Keys:
+  1) Every work-group copies its output tile plus an R-wide halo into local_accessor memory once, waits on a
+     group_barrier, then computes all of its outputs from local memory. Outside the grid the halo is 0 ("same" padding).
+  2) The radius R (and the channel counts) are template parameters, so the filter loops have constant trip counts
+     and are fully unrolled.
+  3) Kernels:
+     • Stencil1D<R>, Stencil2D<R>, Stencil3D<R>: one dense (2R+1)^D filter, passed by value.
+     • Conv2D<R, CIN, COUT>: direct convolution, [CIN][H][W] -> [COUT][H][W], all CIN tiles in local memory,
+       every work-item keeps COUT accumulators in registers.
+     • Depthwise2D<R, C>: one filter per channel, one channel per work-group.
+     • CausalConv1D<K, C>: y[b][t][c] = bias[c] + sum_k w[c][k] * x[b][t - K + 1 + k][c], channels-last,
+       the halo is the K - 1 previous time steps (the short conv in front of sequence-model blocks).
+
+Tile of Stencil2D, TILE = 16, R = 1:
+
+       ┌─────────────────────┐
+       │ h  h  h  ...  h  h  │   h: halo, loaded but not written
+       │ h ┌───────────────┐ │
+       │ h │ 16 x 16       │ │   every input value is read from global memory once per work-group
+       │ h │ outputs       │ │   instead of (2R+1)^2 times
+       │ h └───────────────┘ │
+       │ h  h  h  ...  h  h  │
+       └─────────────────────┘   (16 + 2R)^2 floats in local memory
+*/
+
+constexpr int TILE = 16;   // 2D tile edge, work-group = TILE x TILE
+constexpr int TILE3 = 8;   // 3D tile edge, work-group = TILE3^3
+constexpr int TILE1 = 256; // 1D tile, work-group = TILE1
+
+template <int R> struct Filter1D { float w[2 * R + 1]; };
+template <int R> struct Filter2D { float w[2 * R + 1][2 * R + 1]; };
+template <int R> struct Filter3D { float w[2 * R + 1][2 * R + 1][2 * R + 1]; };
+
+size_t RoundUp(size_t n, size_t m) { return (n + m - 1) / m * m; }
+
+// Copies the (TILE + 2R)^2 input tile whose first output is (y0, x0) into tile[offset...], 0 outside the image.
+// `lid` / `threads`: this work-item's index among the work-items that share the copy.
+template <int R, typename Tile>
+void LoadTile2D(const float *src, int H, int W, int y0, int x0, const Tile &tile, size_t offset, int lid, int threads) {
+    constexpr int TW = TILE + 2 * R;
+    for (int i = lid; i < TW * TW; i += threads) {
+        const int gy = y0 + i / TW - R, gx = x0 + i % TW - R;
+        tile[offset + i] = gy >= 0 && gy < H && gx >= 0 && gx < W ? src[size_t(gy) * W + gx] : 0.0f;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Stencils
+// ---------------------------------------------------------------------------------------------------------------------
+template <int R>
+sycl::event Stencil1D(sycl::queue &q, const float *x, float *y, int n, Filter1D<R> f) {
+    return q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<float, 1> tile(sycl::range<1>(TILE1 + 2 * R), h);
+        h.parallel_for(sycl::nd_range<1>(RoundUp(n, TILE1), TILE1), [=](sycl::nd_item<1> item) {
+            const int lid = item.get_local_id(0);
+            const int base = item.get_group(0) * TILE1 - R;
+            for (int i = lid; i < TILE1 + 2 * R; i += TILE1) {
+                const int g = base + i;
+                tile[i] = g >= 0 && g < n ? x[g] : 0.0f;
+            }
+            sycl::group_barrier(item.get_group());
+
+            const int i = item.get_global_id(0);
+            if (i >= n)
+                return;
+            float sum = 0.0f;
+#pragma unroll
+            for (int k = 0; k < 2 * R + 1; ++k)
+                sum += f.w[k] * tile[lid + k];
+            y[i] = sum;
+        });
+    });
+}
+
+template <int R>
+sycl::event Stencil2D(sycl::queue &q, const float *x, float *y, int H, int W, Filter2D<R> f) {
+    constexpr int TW = TILE + 2 * R;
+    return q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<float, 1> tile(sycl::range<1>(TW * TW), h);
+        h.parallel_for(sycl::nd_range<2>({RoundUp(H, TILE), RoundUp(W, TILE)}, {TILE, TILE}), [=](sycl::nd_item<2> item) {
+            const int ly = item.get_local_id(0), lx = item.get_local_id(1);
+            LoadTile2D<R>(x, H, W, item.get_group(0) * TILE, item.get_group(1) * TILE, tile, 0, ly * TILE + lx,
+                          TILE * TILE);
+            sycl::group_barrier(item.get_group());
+
+            const int gy = item.get_global_id(0), gx = item.get_global_id(1);
+            if (gy >= H || gx >= W)
+                return;
+            float sum = 0.0f;
+#pragma unroll
+            for (int dy = 0; dy < 2 * R + 1; ++dy)
+#pragma unroll
+                for (int dx = 0; dx < 2 * R + 1; ++dx)
+                    sum += f.w[dy][dx] * tile[(ly + dy) * TW + lx + dx];
+            y[size_t(gy) * W + gx] = sum;
+        });
+    });
+}
+
+// The same filter read straight from global memory, the baseline for Stencil2D.
+template <int R>
+sycl::event Stencil2DNaive(sycl::queue &q, const float *x, float *y, int H, int W, Filter2D<R> f) {
+    return q.parallel_for(sycl::range<2>(H, W), [=](sycl::item<2> it) {
+        const int gy = it[0], gx = it[1];
+        float sum = 0.0f;
+        for (int dy = -R; dy <= R; ++dy)
+            for (int dx = -R; dx <= R; ++dx) {
+                const int sy = gy + dy, sx = gx + dx;
+                if (sy >= 0 && sy < H && sx >= 0 && sx < W)
+                    sum += f.w[dy + R][dx + R] * x[size_t(sy) * W + sx];
+            }
+        y[size_t(gy) * W + gx] = sum;
+    });
+}
+
+template <int R>
+sycl::event Stencil3D(sycl::queue &q, const float *x, float *y, int D, int H, int W, Filter3D<R> f) {
+    constexpr int TW = TILE3 + 2 * R;
+    constexpr int THREADS = TILE3 * TILE3 * TILE3;
+    return q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<float, 1> tile(sycl::range<1>(TW * TW * TW), h);
+        h.parallel_for(sycl::nd_range<3>({RoundUp(D, TILE3), RoundUp(H, TILE3), RoundUp(W, TILE3)}, {TILE3, TILE3, TILE3}),
+                       [=](sycl::nd_item<3> item) {
+            const int lz = item.get_local_id(0), ly = item.get_local_id(1), lx = item.get_local_id(2);
+            const int z0 = item.get_group(0) * TILE3 - R, y0 = item.get_group(1) * TILE3 - R,
+                      x0 = item.get_group(2) * TILE3 - R;
+            for (int i = (lz * TILE3 + ly) * TILE3 + lx; i < TW * TW * TW; i += THREADS) {
+                const int gz = z0 + i / (TW * TW), gy = y0 + i / TW % TW, gx = x0 + i % TW;
+                tile[i] = gz >= 0 && gz < D && gy >= 0 && gy < H && gx >= 0 && gx < W
+                              ? x[(size_t(gz) * H + gy) * W + gx]
+                              : 0.0f;
+            }
+            sycl::group_barrier(item.get_group());
+
+            const int gz = item.get_global_id(0), gy = item.get_global_id(1), gx = item.get_global_id(2);
+            if (gz >= D || gy >= H || gx >= W)
+                return;
+            float sum = 0.0f;
+#pragma unroll
+            for (int dz = 0; dz < 2 * R + 1; ++dz)
+#pragma unroll
+                for (int dy = 0; dy < 2 * R + 1; ++dy)
+#pragma unroll
+                    for (int dx = 0; dx < 2 * R + 1; ++dx)
+                        sum += f.w[dz][dy][dx] * tile[((lz + dz) * TW + ly + dy) * TW + lx + dx];
+            y[(size_t(gz) * H + gy) * W + gx] = sum;
+        });
+    });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Convolutions
+// ---------------------------------------------------------------------------------------------------------------------
+
+// x[CIN][H][W], w[COUT][CIN][2R+1][2R+1], y[COUT][H][W].
+template <int R, int CIN, int COUT>
+sycl::event Conv2D(sycl::queue &q, const float *x, const float *w, float *y, int H, int W) {
+    constexpr int K = 2 * R + 1;
+    constexpr int TW = TILE + 2 * R;
+    return q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<float, 1> tile(sycl::range<1>(CIN * TW * TW), h);
+        h.parallel_for(sycl::nd_range<2>({RoundUp(H, TILE), RoundUp(W, TILE)}, {TILE, TILE}), [=](sycl::nd_item<2> item) {
+            const int ly = item.get_local_id(0), lx = item.get_local_id(1);
+            const int y0 = item.get_group(0) * TILE, x0 = item.get_group(1) * TILE;
+            for (int ci = 0; ci < CIN; ++ci)
+                LoadTile2D<R>(x + size_t(ci) * H * W, H, W, y0, x0, tile, size_t(ci) * TW * TW, ly * TILE + lx,
+                              TILE * TILE);
+            sycl::group_barrier(item.get_group());
+
+            const int gy = y0 + ly, gx = x0 + lx;
+            if (gy >= H || gx >= W)
+                return;
+            float acc[COUT] = {};
+            for (int ci = 0; ci < CIN; ++ci) {
+#pragma unroll
+                for (int dy = 0; dy < K; ++dy)
+#pragma unroll
+                    for (int dx = 0; dx < K; ++dx) {
+                        const float v = tile[(ci * TW + ly + dy) * TW + lx + dx];
+#pragma unroll
+                        for (int co = 0; co < COUT; ++co)
+                            acc[co] += w[((co * CIN + ci) * K + dy) * K + dx] * v;
+                    }
+            }
+#pragma unroll
+            for (int co = 0; co < COUT; ++co)
+                y[(size_t(co) * H + gy) * W + gx] = acc[co];
+        });
+    });
+}
+
+// x[C][H][W], w[C][2R+1][2R+1], y[C][H][W], work-group dimension 0 is the channel.
+template <int R, int C>
+sycl::event Depthwise2D(sycl::queue &q, const float *x, const float *w, float *y, int H, int W) {
+    constexpr int K = 2 * R + 1;
+    constexpr int TW = TILE + 2 * R;
+    return q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<float, 1> tile(sycl::range<1>(TW * TW), h);
+        h.parallel_for(sycl::nd_range<3>({C, RoundUp(H, TILE), RoundUp(W, TILE)}, {1, TILE, TILE}),
+                       [=](sycl::nd_item<3> item) {
+            const int c = item.get_group(0);
+            const int ly = item.get_local_id(1), lx = item.get_local_id(2);
+            const size_t plane = size_t(c) * H * W;
+            LoadTile2D<R>(x + plane, H, W, item.get_group(1) * TILE, item.get_group(2) * TILE, tile, 0,
+                          ly * TILE + lx, TILE * TILE);
+            sycl::group_barrier(item.get_group());
+
+            const int gy = item.get_global_id(1), gx = item.get_global_id(2);
+            if (gy >= H || gx >= W)
+                return;
+            const float *wc = w + c * K * K;
+            float sum = 0.0f;
+#pragma unroll
+            for (int dy = 0; dy < K; ++dy)
+#pragma unroll
+                for (int dx = 0; dx < K; ++dx)
+                    sum += wc[dy * K + dx] * tile[(ly + dy) * TW + lx + dx];
+            y[plane + size_t(gy) * W + gx] = sum;
+        });
+    });
+}
+
+// x[B][T][C], w[C][K], bias[C], y[B][T][C]. A work-group covers TT time steps of one sequence, its tile is the
+// contiguous block x[b][t0 - K + 1 .. t0 + TT)[0 .. C) in global memory.
+template <int K, int C>
+sycl::event CausalConv1D(sycl::queue &q, const float *x, const float *w, const float *bias, float *y, int B, int T) {
+    constexpr int TT = std::max(16, 4096 / C); // time steps per work-group, the tile stays <= ~20 KB
+    constexpr int WG = 256;
+    const size_t tiles = (T + TT - 1) / TT;
+    return q.submit([&](sycl::handler &h) {
+        sycl::local_accessor<float, 1> tile(sycl::range<1>((TT + K - 1) * C), h);
+        h.parallel_for(sycl::nd_range<2>({size_t(B), tiles * WG}, {1, WG}), [=](sycl::nd_item<2> item) {
+            const int b = item.get_group(0);
+            const int t0 = item.get_group(1) * TT;
+            const int lid = item.get_local_id(1);
+            const float *xb = x + size_t(b) * T * C;
+            for (int i = lid; i < (TT + K - 1) * C; i += WG) {
+                const int t = t0 - (K - 1) + i / C;
+                tile[i] = t >= 0 && t < T ? xb[size_t(t) * C + i % C] : 0.0f;
+            }
+            sycl::group_barrier(item.get_group());
+
+            for (int i = lid; i < TT * C; i += WG) {
+                const int t = t0 + i / C, c = i % C;
+                if (t >= T)
+                    break;
+                float sum = bias[c];
+#pragma unroll
+                for (int k = 0; k < K; ++k)
+                    sum += w[c * K + k] * tile[i + k * C];
+                y[(size_t(b) * T + t) * C + c] = sum;
+            }
+        });
+    });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example: every kernel against a host reference, tiled vs naive timing for the 2D stencil.
+// ---------------------------------------------------------------------------------------------------------------------
+template <typename Fn>
+double TimeUs(Fn &&fn, int iters = 10) {
+    fn();
+    auto tag_0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+        fn();
+    auto tag_1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(tag_1 - tag_0).count() / iters;
+}
+
+struct Device {
+    sycl::queue &q;
+    std::vector<float *> ptrs;
+    float *upload(const std::vector<float> &v) {
+        float *d = sycl::malloc_device<float>(v.size(), q);
+        q.memcpy(d, v.data(), v.size() * sizeof(float)).wait();
+        ptrs.push_back(d);
+        return d;
+    }
+    float *alloc(size_t n) {
+        ptrs.push_back(sycl::malloc_device<float>(n, q));
+        return ptrs.back();
+    }
+    std::vector<float> download(const float *d, size_t n) {
+        std::vector<float> v(n);
+        q.memcpy(v.data(), d, n * sizeof(float)).wait();
+        return v;
+    }
+    ~Device() {
+        for (float *p : ptrs)
+            sycl::free(p, q);
+    }
+};
+
+std::vector<float> Wave(size_t n, float f) {
+    std::vector<float> v(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = std::sin(f * float(i % 100003));
+    return v;
+}
+
+int Check(const std::vector<float> &ref, const std::vector<float> &out) {
+    int errors = 0;
+    for (size_t i = 0; i < ref.size(); ++i)
+        errors += std::abs(ref[i] - out[i]) > 1e-4f * (1.0f + std::abs(ref[i]));
+    return errors;
+}
+
+// Host reference for one [H][W] plane, zero padding.
+template <int K>
+float HostTap2D(const float *x, int H, int W, int gy, int gx, const float (&w)[K][K]) {
+    float sum = 0.0f;
+    for (int dy = 0; dy < K; ++dy)
+        for (int dx = 0; dx < K; ++dx) {
+            const int sy = gy + dy - K / 2, sx = gx + dx - K / 2;
+            if (sy >= 0 && sy < H && sx >= 0 && sx < W)
+                sum += w[dy][dx] * x[size_t(sy) * W + sx];
+        }
+    return sum;
+}
+
+int main() {
+    sycl::queue q;
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+    Device dev{q, {}};
+
+    {
+        constexpr int R = 4, N = 1 << 24;
+        Filter1D<R> f;
+        for (int k = 0; k < 2 * R + 1; ++k)
+            f.w[k] = 1.0f / (2 * R + 1);
+        auto x = Wave(N, 0.01f);
+        float *d_x = dev.upload(x), *d_y = dev.alloc(N);
+        double us = TimeUs([&] { Stencil1D<R>(q, d_x, d_y, N, f).wait(); });
+        std::vector<float> ref(N, 0.0f);
+        for (int i = 0; i < N; ++i)
+            for (int k = -R; k <= R; ++k)
+                if (i + k >= 0 && i + k < N)
+                    ref[i] += f.w[k + R] * x[i + k];
+        std::cout << "Stencil1D R=" << R << ": " << us << " usec, " << 2.0 * N * sizeof(float) / us / 1e3
+                  << " GB/s, errors: " << Check(ref, dev.download(d_y, N)) << std::endl;
+    }
+
+    {
+        constexpr int R = 2, H = 4096, W = 4096;
+        Filter2D<R> f;
+        for (int dy = 0; dy < 2 * R + 1; ++dy)
+            for (int dx = 0; dx < 2 * R + 1; ++dx)
+                f.w[dy][dx] = 0.01f * (dy * (2 * R + 1) + dx + 1);
+        auto x = Wave(size_t(H) * W, 0.001f);
+        float *d_x = dev.upload(x), *d_y = dev.alloc(size_t(H) * W);
+        std::vector<float> ref(size_t(H) * W);
+        for (int gy = 0; gy < H; ++gy)
+            for (int gx = 0; gx < W; ++gx)
+                ref[size_t(gy) * W + gx] = HostTap2D(x.data(), H, W, gy, gx, f.w);
+        double naive = TimeUs([&] { Stencil2DNaive<R>(q, d_x, d_y, H, W, f).wait(); });
+        int naive_errors = Check(ref, dev.download(d_y, ref.size()));
+        double tiled = TimeUs([&] { Stencil2D<R>(q, d_x, d_y, H, W, f).wait(); });
+        std::cout << "Stencil2D R=" << R << ": naive " << naive << " usec (errors: " << naive_errors << "), tiled "
+                  << tiled << " usec, " << 2.0 * H * W * sizeof(float) / tiled / 1e3
+                  << " GB/s, errors: " << Check(ref, dev.download(d_y, ref.size())) << std::endl;
+    }
+
+    {
+        constexpr int R = 1, D = 256, H = 256, W = 256;
+        Filter3D<R> f;
+        for (int dz = 0; dz < 2 * R + 1; ++dz)
+            for (int dy = 0; dy < 2 * R + 1; ++dy)
+                for (int dx = 0; dx < 2 * R + 1; ++dx)
+                    f.w[dz][dy][dx] = dz == R && dy == R && dx == R ? -26.0f / 27 : 1.0f / 27;
+        auto x = Wave(size_t(D) * H * W, 0.002f);
+        float *d_x = dev.upload(x), *d_y = dev.alloc(x.size());
+        double us = TimeUs([&] { Stencil3D<R>(q, d_x, d_y, D, H, W, f).wait(); });
+        std::vector<float> ref(x.size(), 0.0f);
+        for (int gz = 0; gz < D; ++gz)
+            for (int gy = 0; gy < H; ++gy)
+                for (int gx = 0; gx < W; ++gx) {
+                    float sum = 0.0f;
+                    for (int dz = -R; dz <= R; ++dz)
+                        if (gz + dz >= 0 && gz + dz < D)
+                            sum += HostTap2D(x.data() + size_t(gz + dz) * H * W, H, W, gy, gx, f.w[dz + R]);
+                    ref[(size_t(gz) * H + gy) * W + gx] = sum;
+                }
+        std::cout << "Stencil3D R=" << R << ": " << us << " usec, " << 2.0 * x.size() * sizeof(float) / us / 1e3
+                  << " GB/s, errors: " << Check(ref, dev.download(d_y, ref.size())) << std::endl;
+    }
+
+    {
+        constexpr int R = 1, K = 2 * R + 1, CIN = 4, COUT = 8, H = 1024, W = 1024;
+        auto x = Wave(size_t(CIN) * H * W, 0.003f);
+        auto w = Wave(size_t(COUT) * CIN * K * K, 0.7f);
+        float *d_x = dev.upload(x), *d_w = dev.upload(w), *d_y = dev.alloc(size_t(COUT) * H * W);
+        double us = TimeUs([&] { Conv2D<R, CIN, COUT>(q, d_x, d_w, d_y, H, W).wait(); });
+        std::vector<float> ref(size_t(COUT) * H * W, 0.0f);
+        for (int co = 0; co < COUT; ++co)
+            for (int ci = 0; ci < CIN; ++ci) {
+                float wk[K][K];
+                for (int i = 0; i < K * K; ++i)
+                    wk[i / K][i % K] = w[(size_t(co) * CIN + ci) * K * K + i];
+                for (int gy = 0; gy < H; ++gy)
+                    for (int gx = 0; gx < W; ++gx)
+                        ref[(size_t(co) * H + gy) * W + gx] += HostTap2D(x.data() + size_t(ci) * H * W, H, W, gy, gx, wk);
+            }
+        std::cout << "Conv2D " << CIN << "->" << COUT << " R=" << R << ": " << us << " usec, "
+                  << 2.0 * COUT * CIN * K * K * H * W / us / 1e3
+                  << " GFLOP/s, errors: " << Check(ref, dev.download(d_y, ref.size())) << std::endl;
+    }
+
+    {
+        constexpr int R = 1, K = 2 * R + 1, C = 32, H = 512, W = 512;
+        auto x = Wave(size_t(C) * H * W, 0.005f);
+        auto w = Wave(size_t(C) * K * K, 0.3f);
+        float *d_x = dev.upload(x), *d_w = dev.upload(w), *d_y = dev.alloc(x.size());
+        double us = TimeUs([&] { Depthwise2D<R, C>(q, d_x, d_w, d_y, H, W).wait(); });
+        std::vector<float> ref(x.size());
+        for (int c = 0; c < C; ++c) {
+            float wk[K][K];
+            for (int i = 0; i < K * K; ++i)
+                wk[i / K][i % K] = w[size_t(c) * K * K + i];
+            for (int gy = 0; gy < H; ++gy)
+                for (int gx = 0; gx < W; ++gx)
+                    ref[(size_t(c) * H + gy) * W + gx] = HostTap2D(x.data() + size_t(c) * H * W, H, W, gy, gx, wk);
+        }
+        std::cout << "Depthwise2D C=" << C << " R=" << R << ": " << us << " usec, "
+                  << 2.0 * x.size() * sizeof(float) / us / 1e3
+                  << " GB/s, errors: " << Check(ref, dev.download(d_y, ref.size())) << std::endl;
+    }
+
+    {
+        constexpr int K = 4, C = 256, B = 4, T = 4096;
+        auto x = Wave(size_t(B) * T * C, 0.0007f);
+        auto w = Wave(size_t(C) * K, 0.9f);
+        auto bias = Wave(C, 0.1f);
+        float *d_x = dev.upload(x), *d_w = dev.upload(w), *d_b = dev.upload(bias), *d_y = dev.alloc(x.size());
+        double us = TimeUs([&] { CausalConv1D<K, C>(q, d_x, d_w, d_b, d_y, B, T).wait(); });
+        std::vector<float> ref(x.size());
+        for (int b = 0; b < B; ++b)
+            for (int t = 0; t < T; ++t)
+                for (int c = 0; c < C; ++c) {
+                    float sum = bias[c];
+                    for (int k = 0; k < K; ++k) {
+                        const int s = t - K + 1 + k;
+                        if (s >= 0)
+                            sum += w[c * K + k] * x[(size_t(b) * T + s) * C + c];
+                    }
+                    ref[(size_t(b) * T + t) * C + c] = sum;
+                }
+        std::cout << "CausalConv1D K=" << K << " C=" << C << ": " << us << " usec, "
+                  << 2.0 * x.size() * sizeof(float) / us / 1e3
+                  << " GB/s, errors: " << Check(ref, dev.download(d_y, ref.size())) << std::endl;
+    }
+    return 0;
+}
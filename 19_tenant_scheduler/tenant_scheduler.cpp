@@ -0,0 +1,430 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Keys:
+  1) TenantScheduler owns two in-order queues per device (interactive, batch) and one dispatcher thread.
+     Callers never touch a sycl::queue, they submit jobs tagged with tenant and class.
+  2) A job is a range [0, n) and a SliceFn launching [begin, end) of it. Batch jobs are split into slices of at most
+     `slice` items, so one big kernel is several short launches and interactive work can get in between them.
+  3) Order of submission:
+     • strict priority between classes: an eligible interactive slice always goes first.
+     • self-clocked fair queuing (a WFQ variant) between the tenants of one class:
+         tag = max(V, finish[tenant]) + items / weight,   the lowest tag is submitted next,
+         finish[tenant] = V = tag.
+       A tenant with weight 3 gets 3x the items of a tenant with weight 1 while both are backlogged.
+  4) Caps: max_in_flight slices per tenant, and at most `device_depth` batch slices in flight per device.
+     A shallow device queue bounds how long an interactive job waits behind batch work, to about one slice.
+  5) Metrics: job latency (submit -> last slice complete) per class, p50 / p99 / max.
+  6) Placement: a job's first slice goes to the least loaded device, every later slice of that job follows it there.
+     A SliceFn may capture device USM only when the scheduler has one device (or the USM lives on every candidate);
+     with several devices use shared or host USM. Jobs, not slices, are spread over devices.
+  7) A SliceFn that throws fails its job: no further slices are launched and the job's future rethrows the exception
+     once its already launched slices have completed.
+
+                 ┌─ interactive: tenant A ─┐
+  submit() ──►   │                          ├─► dispatcher ─► device 0: [interactive q] [batch q] (<= depth in flight)
+                 └─ batch: tenant B, C ────┘    priority        device 1: ...
+                                                 + fair tags
+
+Completion is detected by polling event status, like Wake::Poll in 9_coroutine.
+*/
+
+enum class JobClass { Interactive = 0, Batch = 1 };
+
+const char *ClassName(JobClass c) { return c == JobClass::Interactive ? "interactive" : "batch"; }
+
+struct TenantConfig {
+    double weight = 1.0;
+    size_t max_in_flight = 4; // slices
+};
+
+using SliceFn = std::function<sycl::event(sycl::queue &, size_t begin, size_t end)>;
+using Clock = std::chrono::steady_clock;
+
+double Percentile(std::vector<double> v, double p) {
+    if (v.empty())
+        return 0.0;
+    size_t idx = std::min(v.size() - 1, size_t(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + idx, v.end());
+    return v[idx];
+}
+
+class TenantScheduler {
+public:
+    explicit TenantScheduler(const std::vector<sycl::device> &devices, size_t device_depth = 2)
+        : device_depth_(device_depth) {
+        for (auto &d : devices)
+            devices_.push_back(std::make_unique<Device>(d));
+        dispatcher_ = std::thread([this] { run(); });
+    }
+
+    ~TenantScheduler() {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        dispatcher_.join();
+    }
+
+    int add_tenant(std::string name, TenantConfig cfg = {}) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        tenants_.push_back({std::move(name), cfg});
+        return int(tenants_.size()) - 1;
+    }
+
+    // `slice` = 0 launches the job in one piece. The future is ready when every slice has completed.
+    std::shared_future<void> submit(int tenant, JobClass cls, size_t n, size_t slice, SliceFn fn) {
+        auto job = std::make_shared<Job>();
+        job->tenant = tenant;
+        job->cls = cls;
+        job->n = n;
+        job->slice = slice ? slice : n;
+        job->fn = std::move(fn);
+        job->submitted = Clock::now();
+        std::shared_future<void> done = job->done.get_future().share();
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            tenants_.at(tenant).jobs[int(cls)].push_back(std::move(job));
+            ++pending_;
+        }
+        wake_.notify_all();
+        return done;
+    }
+
+    // Wait until every job submitted so far has completed.
+    void drain() {
+        std::unique_lock<std::mutex> lk(mutex_);
+        idle_.wait(lk, [this] { return pending_ == 0; });
+    }
+
+    void print_metrics(std::ostream &os) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        os << std::fixed << std::setprecision(1);
+        for (int c = 0; c < 2; ++c) {
+            auto &lat = latency_us_[c];
+            os << "  " << std::left << std::setw(12) << ClassName(JobClass(c)) << std::right << " jobs: " << lat.size()
+               << ", latency p50/p99/max: " << Percentile(lat, 0.5) << "/" << Percentile(lat, 0.99) << "/"
+               << (lat.empty() ? 0.0 : *std::max_element(lat.begin(), lat.end())) << " usec" << std::endl;
+        }
+        for (auto &t : tenants_)
+            os << "  tenant " << std::left << std::setw(12) << t.name << std::right << " weight " << t.cfg.weight
+               << ", items: " << t.items << ", last job done at " << t.last_done_ms << " ms" << std::endl;
+        os << std::defaultfloat;
+    }
+
+private:
+    struct Device;
+
+    struct Job {
+        int tenant;
+        JobClass cls;
+        size_t n, slice, next = 0;
+        size_t outstanding = 0; // dispatched, not yet complete
+        Device *device = nullptr; // set by the first slice, later slices follow it
+        std::exception_ptr error;
+        SliceFn fn;
+        Clock::time_point submitted;
+        std::promise<void> done;
+    };
+
+    struct Tenant {
+        std::string name;
+        TenantConfig cfg;
+        std::deque<std::shared_ptr<Job>> jobs[2];
+        size_t in_flight = 0;
+        double finish[2] = {0.0, 0.0};
+        size_t items = 0;
+        double last_done_ms = 0.0;
+    };
+
+    struct Device {
+        explicit Device(const sycl::device &d)
+            : queues{sycl::queue(d, sycl::property::queue::in_order()), sycl::queue(d, sycl::property::queue::in_order())} {}
+        sycl::queue queues[2];
+        size_t in_flight[2] = {0, 0};
+    };
+
+    struct InFlight {
+        sycl::event event;
+        std::shared_ptr<Job> job;
+        Device *device;
+    };
+
+    struct Pick {
+        JobClass cls;
+        Tenant *tenant = nullptr;
+        Device *device = nullptr;
+        double tag = 0.0;
+    };
+
+    bool has_room(const Device &d, JobClass cls) const {
+        return cls == JobClass::Interactive || d.in_flight[1] < device_depth_;
+    }
+
+    Device *least_loaded(JobClass cls) {
+        Device *best = nullptr;
+        for (auto &d : devices_) {
+            if (!has_room(*d, cls))
+                continue;
+            if (!best || d->in_flight[0] + d->in_flight[1] < best->in_flight[0] + best->in_flight[1])
+                best = d.get();
+        }
+        return best;
+    }
+
+    // Lowest fair-queuing tag among the tenants of `cls` that are below their cap and whose head job has a device
+    // with room: its own once started, the least loaded one otherwise.
+    bool pick(JobClass cls, Pick &p) {
+        const int c = int(cls);
+        p.cls = cls;
+        p.tenant = nullptr;
+        Device *free_device = least_loaded(cls);
+        for (auto &t : tenants_) {
+            if (t.jobs[c].empty() || t.in_flight >= t.cfg.max_in_flight)
+                continue;
+            const Job &job = *t.jobs[c].front();
+            Device *device = job.device ? (has_room(*job.device, cls) ? job.device : nullptr) : free_device;
+            if (!device)
+                continue;
+            const size_t items = std::min(job.slice, job.n - job.next);
+            const double tag = std::max(vtime_[c], t.finish[c]) + double(items) / t.cfg.weight;
+            if (!p.tenant || tag < p.tag) {
+                p.tenant = &t;
+                p.device = device;
+                p.tag = tag;
+            }
+        }
+        return p.tenant != nullptr;
+    }
+
+    // Last slice of `job` retired, caller holds the lock.
+    void complete(Job &job, Tenant &t) {
+        auto now = Clock::now();
+        t.last_done_ms = std::chrono::duration<double, std::milli>(now - start_).count();
+        if (job.error) {
+            job.done.set_exception(job.error);
+        } else {
+            latency_us_[int(job.cls)].push_back(std::chrono::duration<double, std::micro>(now - job.submitted).count());
+            job.done.set_value();
+        }
+        if (--pending_ == 0)
+            idle_.notify_all();
+    }
+
+    // Retires completed slices, caller holds the lock.
+    void reap() {
+        auto it = in_flight_.begin();
+        while (it != in_flight_.end()) {
+            auto status = it->event.get_info<sycl::info::event::command_execution_status>();
+            if (status != sycl::info::event_command_status::complete) {
+                ++it;
+                continue;
+            }
+            Job &job = *it->job;
+            Tenant &t = tenants_[job.tenant];
+            --t.in_flight;
+            --it->device->in_flight[int(job.cls)];
+            if (--job.outstanding == 0 && job.next == job.n)
+                complete(job, t);
+            it = in_flight_.erase(it);
+        }
+    }
+
+    // Submits the next slice of the picked tenant's head job, the launch itself runs without the lock.
+    void dispatch(const Pick &p, std::unique_lock<std::mutex> &lk) {
+        const int c = int(p.cls);
+        Tenant &t = *p.tenant;
+        std::shared_ptr<Job> job = t.jobs[c].front();
+        const size_t begin = job->next, end = std::min(job->n, begin + job->slice);
+        job->next = end;
+        if (end == job->n)
+            t.jobs[c].pop_front();
+        ++job->outstanding;
+        ++t.in_flight;
+        ++p.device->in_flight[c];
+        t.finish[c] = vtime_[c] = p.tag;
+        t.items += end - begin;
+        job->device = p.device;
+        sycl::queue &q = p.device->queues[c];
+
+        lk.unlock();
+        sycl::event e;
+        std::exception_ptr error;
+        try {
+            e = job->fn(q, begin, end);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lk.lock();
+        if (!error) {
+            in_flight_.push_back({e, std::move(job), p.device});
+            return;
+        }
+
+        // The slice never launched: undo its accounting and drop the rest of the job.
+        --t.in_flight;
+        --p.device->in_flight[c];
+        if (!job->error)
+            job->error = error;
+        if (job->next != job->n) {
+            t.jobs[c].erase(std::find(t.jobs[c].begin(), t.jobs[c].end(), job));
+            job->next = job->n;
+        }
+        if (--job->outstanding == 0)
+            complete(*job, t);
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lk(mutex_);
+        for (;;) {
+            reap();
+            Pick p;
+            if (pick(JobClass::Interactive, p) || pick(JobClass::Batch, p)) {
+                dispatch(p, lk);
+                continue;
+            }
+            if (stop_ && pending_ == 0)
+                return;
+            // Nothing eligible: sleep until a submit, or poll the in-flight slices again shortly.
+            wake_.wait_for(lk, in_flight_.empty() ? std::chrono::microseconds(10000) : std::chrono::microseconds(50));
+        }
+    }
+
+    std::vector<std::unique_ptr<Device>> devices_;
+    const size_t device_depth_;
+    std::vector<Tenant> tenants_;
+    std::vector<InFlight> in_flight_;
+    double vtime_[2] = {0.0, 0.0};
+    std::vector<double> latency_us_[2];
+    size_t pending_ = 0;
+    bool stop_ = false;
+    Clock::time_point start_ = Clock::now();
+    std::mutex mutex_;
+    std::condition_variable wake_, idle_;
+    std::thread dispatcher_;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example: two batch tenants (weights 1 and 3) keep the device busy, one interactive tenant sends small jobs
+// every INTERVAL. Baseline: everything on one shared queue, batch kernels launched whole.
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr size_t BATCH_N = 1 << 24, BATCH_SLICE = 1 << 20, INTERACTIVE_N = 1 << 14;
+constexpr int BATCH_JOBS = 8, INTERACTIVE_JOBS = 100;
+constexpr auto INTERVAL = std::chrono::milliseconds(2);
+
+// Some arithmetic per element to stand in for a real kernel, count[i] += 1 so every element can be checked.
+sycl::event Busy(sycl::queue &q, float *count, size_t begin, size_t end) {
+    return q.parallel_for(sycl::range<1>(end - begin), [=](sycl::id<1> i) {
+        float *c = count + begin + i;
+        float acc = *c;
+        for (int k = 0; k < 64; ++k)
+            acc = sycl::fma(acc, 0.999f, 0.001f);
+        *c = *c + 1.0f + (acc < -1.0f ? acc : 0.0f);
+    });
+}
+
+int Check(sycl::queue &q, const float *count, size_t n, float expect) {
+    std::vector<float> out(n);
+    q.memcpy(out.data(), count, n * sizeof(float)).wait();
+    int errors = 0;
+    for (float v : out)
+        errors += v != expect;
+    return errors;
+}
+
+int main() {
+    // In-order: the baseline's whole kernels read-modify-write the same buffers, they must not run concurrently.
+    sycl::queue q{sycl::property::queue::in_order()};
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    float *batch_data[2] = {sycl::malloc_device<float>(BATCH_N, q), sycl::malloc_device<float>(BATCH_N, q)};
+    float *interactive_data = sycl::malloc_device<float>(INTERACTIVE_N, q);
+
+    auto reset = [&] {
+        q.fill(batch_data[0], 0.0f, BATCH_N);
+        q.fill(batch_data[1], 0.0f, BATCH_N);
+        q.fill(interactive_data, 0.0f, INTERACTIVE_N);
+        q.wait();
+    };
+
+    {
+        reset();
+        std::vector<double> latency;
+        for (int j = 0; j < BATCH_JOBS; ++j)
+            for (int t = 0; t < 2; ++t)
+                Busy(q, batch_data[t], 0, BATCH_N);
+        for (int j = 0; j < INTERACTIVE_JOBS; ++j) {
+            std::this_thread::sleep_for(INTERVAL);
+            auto tag_0 = Clock::now();
+            Busy(q, interactive_data, 0, INTERACTIVE_N).wait();
+            latency.push_back(std::chrono::duration<double, std::micro>(Clock::now() - tag_0).count());
+        }
+        q.wait();
+        std::cout << "shared queue, whole kernels:" << std::endl;
+        std::cout << "  interactive  latency p50/p99: " << Percentile(latency, 0.5) << "/" << Percentile(latency, 0.99)
+                  << " usec, errors: "
+                  << Check(q, batch_data[0], BATCH_N, BATCH_JOBS) + Check(q, batch_data[1], BATCH_N, BATCH_JOBS) +
+                         Check(q, interactive_data, INTERACTIVE_N, INTERACTIVE_JOBS)
+                  << std::endl;
+    }
+
+    {
+        reset();
+        TenantScheduler sched({q.get_device()});
+        int bulk_a = sched.add_tenant("bulk-a", {1.0, 4});
+        int bulk_b = sched.add_tenant("bulk-b", {3.0, 4});
+        int online = sched.add_tenant("online", {1.0, 8});
+
+        for (int j = 0; j < BATCH_JOBS; ++j) {
+            sched.submit(bulk_a, JobClass::Batch, BATCH_N, BATCH_SLICE,
+                         [&](sycl::queue &sq, size_t b, size_t e) { return Busy(sq, batch_data[0], b, e); });
+            sched.submit(bulk_b, JobClass::Batch, BATCH_N, BATCH_SLICE,
+                         [&](sycl::queue &sq, size_t b, size_t e) { return Busy(sq, batch_data[1], b, e); });
+        }
+        for (int j = 0; j < INTERACTIVE_JOBS; ++j) {
+            std::this_thread::sleep_for(INTERVAL);
+            sched.submit(online, JobClass::Interactive, INTERACTIVE_N, 0,
+                         [&](sycl::queue &sq, size_t b, size_t e) { return Busy(sq, interactive_data, b, e); })
+                .wait();
+        }
+        sched.drain();
+
+        // A failing launch reaches the caller through the future instead of terminating the dispatcher.
+        bool rethrown = false;
+        try {
+            sched.submit(online, JobClass::Interactive, INTERACTIVE_N, 0,
+                         [](sycl::queue &, size_t, size_t) -> sycl::event { throw std::runtime_error("launch failed"); })
+                .get();
+        } catch (const std::runtime_error &) {
+            rethrown = true;
+        }
+
+        std::cout << "TenantScheduler, " << BATCH_N / BATCH_SLICE << " slices per batch job:" << std::endl;
+        sched.print_metrics(std::cout);
+        std::cout << "  errors: "
+                  << Check(q, batch_data[0], BATCH_N, BATCH_JOBS) + Check(q, batch_data[1], BATCH_N, BATCH_JOBS) +
+                         Check(q, interactive_data, INTERACTIVE_N, INTERACTIVE_JOBS)
+                  << ", failing job rethrown: " << (rethrown ? "yes" : "no") << std::endl;
+    }
+
+    sycl::free(batch_data[0], q);
+    sycl::free(batch_data[1], q);
+    sycl::free(interactive_data, q);
+    return 0;
+}
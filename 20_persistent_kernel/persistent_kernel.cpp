@@ -0,0 +1,332 @@
+#include <CL/sycl.hpp>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+Keys:
+  1) One launch, a fixed grid of long-running work-groups (one per compute unit). Every work-group loops:
+     the leader claims the next task descriptor from a USM ring with atomics, the whole work-group executes it,
+     the leader counts it as done. The host appends tasks to the ring while the kernel runs, no new launches.
+  2) TaskRegistry<Ops...>: the set of task functors is fixed at compile time, a task carries the index of its
+     functor (no function pointers in device code), run() dispatches with a fold over the Ops.
+  3) The ring and the control words live in host-visible USM (shared, or host if only host allocations support
+     atomics) and are accessed with memory_scope::system atomics from both sides.
+  4) stop(): the host sets `stop`, every work-group drains the ring and exits, then the kernel completes.
+
+Why:
+  2_queue launches a kernel for every 16-element job and 7_reduction uses a work-group of 1. A kernel launch costs
+  microseconds on the host and the device, a task of a few hundred elements runs in much less.
+
+Ring protocol (capacity is a power of two, counters wrap, only differences are compared):
+  host:    wait slot[tail].state == 0 -> write slot[tail].task -> state = 1 (release) -> tail += 1 (release)
+  leader:  head < tail -> CAS head, head + 1 -> wait state == 1 (acquire) -> copy task to local memory
+           -> state = 0 (release, the host may reuse the slot) -> group runs the task -> done += 1 (release)
+
+  host ──push──► [ slot | slot | slot | ... ]  ◄──claim── WG 0, WG 1, ... WG (compute units - 1)
+                  head ─►          tail ─►
+
+The work-groups never wait for each other, only for the host, so they do not need to be co-resident;
+a work-group that starts late still finds the ring drained and `stop` set and exits.
+*/
+
+constexpr int WG = 256;
+
+struct Task {
+    uint32_t op; // index into the TaskRegistry
+    uint32_t n;
+    float alpha;
+    const float *x;
+    float *y;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Task functors, executed by one whole work-group.
+// ---------------------------------------------------------------------------------------------------------------------
+struct ScaleOp {
+    void operator()(const Task &t, sycl::nd_item<1> item) const {
+        for (uint32_t i = item.get_local_id(0); i < t.n; i += WG)
+            t.y[i] *= t.alpha;
+    }
+};
+
+struct AxpyOp {
+    void operator()(const Task &t, sycl::nd_item<1> item) const {
+        for (uint32_t i = item.get_local_id(0); i < t.n; i += WG)
+            t.y[i] += t.alpha * t.x[i];
+    }
+};
+
+// y[0] = sum(x[0, n))
+struct SumOp {
+    void operator()(const Task &t, sycl::nd_item<1> item) const {
+        float sum = 0.0f;
+        for (uint32_t i = item.get_local_id(0); i < t.n; i += WG)
+            sum += t.x[i];
+        sum = sycl::reduce_over_group(item.get_group(), sum, sycl::plus<float>());
+        if (item.get_local_id(0) == 0)
+            t.y[0] = sum;
+    }
+};
+
+template <typename... Ops>
+struct TaskRegistry {
+    template <typename Op>
+    static constexpr uint32_t id() {
+        uint32_t i = 0, found = UINT32_MAX;
+        ((std::is_same_v<Op, Ops> ? found = i : 0, ++i), ...);
+        return found;
+    }
+
+    // t.op is the same for the whole work-group, so group algorithms inside an Op are fine.
+    static void run(const Task &t, sycl::nd_item<1> item) { run(t, item, std::index_sequence_for<Ops...>{}); }
+
+private:
+    template <size_t... I>
+    static void run(const Task &t, sycl::nd_item<1> item, std::index_sequence<I...>) {
+        ((t.op == I ? Ops{}(t, item) : void()), ...);
+    }
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Persistent executor
+// ---------------------------------------------------------------------------------------------------------------------
+struct Control {
+    uint32_t head; // next slot to claim (device)
+    uint32_t tail; // next slot to fill (host)
+    uint32_t done; // completed tasks (device)
+    uint32_t stop; // set by the host
+};
+
+struct Slot {
+    Task task;
+    uint32_t state; // 0 = free, 1 = ready
+};
+
+template <typename T>
+using SystemAtomic = sycl::atomic_ref<T, sycl::memory_order::acq_rel, sycl::memory_scope::system,
+                                      sycl::access::address_space::global_space>;
+
+template <typename Registry>
+class PersistentExecutor {
+public:
+    PersistentExecutor(sycl::queue &q, uint32_t capacity = 4096, size_t groups = 0) : q_(q), mask_(capacity - 1) {
+        if (capacity == 0 || (capacity & mask_) != 0)
+            throw std::invalid_argument("PersistentExecutor capacity must be a power of two");
+        const sycl::device dev = q.get_device();
+        if (dev.has(sycl::aspect::usm_atomic_shared_allocations)) {
+            ctl_ = sycl::malloc_shared<Control>(1, q);
+            slots_ = sycl::malloc_shared<Slot>(capacity, q);
+        } else if (dev.has(sycl::aspect::usm_atomic_host_allocations)) {
+            ctl_ = sycl::malloc_host<Control>(1, q);
+            slots_ = sycl::malloc_host<Slot>(capacity, q);
+        } else {
+            throw std::runtime_error("PersistentExecutor needs system-scope atomics on shared or host USM");
+        }
+        *ctl_ = {0, 0, 0, 0};
+        for (uint32_t i = 0; i < capacity; ++i)
+            slots_[i].state = 0;
+        if (!groups)
+            groups = dev.get_info<sycl::info::device::max_compute_units>();
+        kernel_ = launch(groups);
+    }
+
+    ~PersistentExecutor() {
+        stop();
+        sycl::free(ctl_, q_);
+        sycl::free(slots_, q_);
+    }
+
+    PersistentExecutor(const PersistentExecutor &) = delete;
+    PersistentExecutor &operator=(const PersistentExecutor &) = delete;
+
+    // Host thread only (single producer). Spins while the slot is still owned by the device.
+    void push(const Task &task) {
+        Slot &slot = slots_[tail_ & mask_];
+        std::atomic_ref<uint32_t> state(slot.state);
+        while (state.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+        slot.task = task;
+        state.store(1, std::memory_order_release);
+        std::atomic_ref<uint32_t>(ctl_->tail).store(++tail_, std::memory_order_release);
+    }
+
+    // Spins until every pushed task has completed, the kernel keeps running.
+    void wait_all() {
+        std::atomic_ref<uint32_t> done(ctl_->done);
+        while (done.load(std::memory_order_acquire) != tail_)
+            std::this_thread::yield();
+    }
+
+    // Drains the ring and lets the kernel exit. Idempotent.
+    void stop() {
+        if (stopped_)
+            return;
+        std::atomic_ref<uint32_t>(ctl_->stop).store(1, std::memory_order_release);
+        kernel_.wait();
+        stopped_ = true;
+    }
+
+    uint32_t executed() const { return std::atomic_ref<uint32_t>(ctl_->done).load(std::memory_order_acquire); }
+
+private:
+    enum : uint32_t { RUN, IDLE, EXIT };
+
+    // Work-group leader only.
+    static uint32_t Claim(Control *ctl, Slot *slots, uint32_t mask, Task &task) {
+        SystemAtomic<uint32_t> head(ctl->head), tail(ctl->tail), stop(ctl->stop);
+        uint32_t h = head.load();
+        if (h == tail.load()) {
+            // `stop` is only set after the last push, so an empty ring after seeing it stays empty.
+            return stop.load() && h == tail.load() ? EXIT : IDLE;
+        }
+        if (!head.compare_exchange_strong(h, h + 1))
+            return IDLE;
+        Slot &slot = slots[h & mask];
+        SystemAtomic<uint32_t> state(slot.state);
+        while (state.load() != 1) {
+        }
+        task = slot.task;
+        state.store(0);
+        return RUN;
+    }
+
+    sycl::event launch(size_t groups) {
+        Control *ctl = ctl_;
+        Slot *slots = slots_;
+        const uint32_t mask = mask_;
+        return q_.submit([&](sycl::handler &h) {
+            sycl::local_accessor<Task, 1> task(sycl::range<1>(1), h);
+            sycl::local_accessor<uint32_t, 1> status(sycl::range<1>(1), h);
+            h.parallel_for(sycl::nd_range<1>(groups * WG, WG), [=](sycl::nd_item<1> item) {
+                const bool leader = item.get_local_id(0) == 0;
+                for (;;) {
+                    if (leader)
+                        status[0] = Claim(ctl, slots, mask, task[0]);
+                    sycl::group_barrier(item.get_group());
+                    const uint32_t s = status[0];
+                    if (s == EXIT)
+                        break;
+                    if (s == RUN)
+                        Registry::run(task[0], item);
+                    // Everybody is done with task[0] / status[0] before the leader overwrites them.
+                    sycl::group_barrier(item.get_group());
+                    if (s == RUN && leader)
+                        SystemAtomic<uint32_t>(ctl->done).fetch_add(1);
+                }
+            });
+        });
+    }
+
+    sycl::queue &q_;
+    const uint32_t mask_;
+    Control *ctl_ = nullptr;
+    Slot *slots_ = nullptr;
+    uint32_t tail_ = 0;
+    bool stopped_ = false;
+    sycl::event kernel_;
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Benchmark: TASKS tiny tasks (scale / axpy / sum of TASK_N elements), one parallel_for per task vs the executor.
+// ---------------------------------------------------------------------------------------------------------------------
+using Registry = TaskRegistry<ScaleOp, AxpyOp, SumOp>;
+
+constexpr uint32_t TASKS = 1 << 16;
+constexpr uint32_t TASK_N = 256;
+
+Task MakeTask(uint32_t i, const float *x, float *y, float *sums) {
+    const size_t off = size_t(i) * TASK_N;
+    switch (i % 3) {
+    case 0: return {Registry::id<ScaleOp>(), TASK_N, 2.0f, nullptr, y + off};
+    case 1: return {Registry::id<AxpyOp>(), TASK_N, 0.5f, x + off, y + off};
+    default: return {Registry::id<SumOp>(), TASK_N, 0.0f, x + off, sums + i};
+    }
+}
+
+int main() {
+    sycl::queue q{sycl::property::queue::in_order()};
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    const size_t N = size_t(TASKS) * TASK_N;
+    std::vector<float> x(N), y(N, 1.0f), sums(TASKS, 0.0f);
+    for (size_t i = 0; i < N; ++i)
+        x[i] = float(i % 7);
+
+    // Host reference.
+    std::vector<float> ref_y(y), ref_sums(sums);
+    for (uint32_t i = 0; i < TASKS; ++i) {
+        const size_t off = size_t(i) * TASK_N;
+        for (uint32_t k = 0; k < TASK_N; ++k) {
+            if (i % 3 == 0)
+                ref_y[off + k] *= 2.0f;
+            else if (i % 3 == 1)
+                ref_y[off + k] += 0.5f * x[off + k];
+            else
+                ref_sums[i] += x[off + k];
+        }
+    }
+
+    float *d_x = sycl::malloc_device<float>(N, q);
+    float *d_y = sycl::malloc_device<float>(N, q);
+    float *d_sums = sycl::malloc_device<float>(TASKS, q);
+    q.memcpy(d_x, x.data(), N * sizeof(float)).wait();
+
+    auto reset = [&] {
+        q.memcpy(d_y, y.data(), N * sizeof(float));
+        q.memcpy(d_sums, sums.data(), TASKS * sizeof(float)).wait();
+    };
+    auto check = [&] {
+        std::vector<float> out_y(N), out_sums(TASKS);
+        q.memcpy(out_y.data(), d_y, N * sizeof(float));
+        q.memcpy(out_sums.data(), d_sums, TASKS * sizeof(float)).wait();
+        int errors = 0;
+        for (size_t i = 0; i < N; ++i)
+            errors += out_y[i] != ref_y[i];
+        for (uint32_t i = 0; i < TASKS; ++i)
+            errors += out_sums[i] != ref_sums[i];
+        return errors;
+    };
+
+    {
+        reset();
+        auto tag_0 = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < TASKS; ++i) {
+            const Task t = MakeTask(i, d_x, d_y, d_sums);
+            q.parallel_for(sycl::nd_range<1>(WG, WG), [=](sycl::nd_item<1> item) { Registry::run(t, item); });
+        }
+        q.wait();
+        auto tag_1 = std::chrono::high_resolution_clock::now();
+        double us = std::chrono::duration<double, std::micro>(tag_1 - tag_0).count();
+        std::cout << "parallel_for per task: " << us << " usec, " << us * 1e3 / TASKS << " ns/task, errors: " << check()
+                  << std::endl;
+    }
+
+    try {
+        reset();
+        PersistentExecutor<Registry> exec(q);
+        auto tag_0 = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < TASKS; ++i)
+            exec.push(MakeTask(i, d_x, d_y, d_sums));
+        exec.wait_all();
+        auto tag_1 = std::chrono::high_resolution_clock::now();
+        exec.stop();
+        double us = std::chrono::duration<double, std::micro>(tag_1 - tag_0).count();
+        std::cout << "persistent executor:   " << us << " usec, " << us * 1e3 / TASKS << " ns/task, executed: "
+                  << exec.executed() << ", errors: " << check() << std::endl;
+    } catch (const std::exception &e) {
+        std::cout << "persistent executor: " << e.what() << std::endl;
+    }
+
+    sycl::free(d_x, q);
+    sycl::free(d_y, q);
+    sycl::free(d_sums, q);
+    return 0;
+}
@@ -0,0 +1,344 @@
+#include <CL/sycl.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+/*
+Keys:
+  1) Philox4x32-10: counter-based RNG, 10 rounds of multiply / xor over a 128-bit counter with a 64-bit key.
+     Value = f(seed, stream, index), no state, so the numbers do not depend on the launch shape, the work-group
+     size or on which work-item computes them, and the host can compute the same numbers.
+       key     = seed (64 bit)
+       counter = {index / 4 (64 bit), stream (64 bit)}, one call gives the 4 values index & ~3 .. index | 3
+     `stream` separates independent uses of one seed (sampling step, layer id, ...).
+  2) Fill kernels: FillUniform [lo, hi), FillNormal (Box-Muller, mean / stddev), FillBernoulli (uint8 0 / 1).
+  3) Dropout: y = keep ? x / (1 - p) : 0 with the keep mask written next to it.
+  4) SampleTopKTopP: one work-group per row of logits [B][V]:
+       • softmax with temperature, top-k then top-p (nucleus) filtering, one categorical sample per row.
+       • The k-th largest logit and the top-p cut-off are found without sorting: the logits are mapped to
+         order-preserving uint32 keys, the threshold key is built bit by bit from the MSB, 32 steps,
+         every step is one count / mass reduction over the row with reduce_over_group.
+       • The sample: prefix sum over the kept probabilities in index order (exclusive_scan_over_group over
+         per-work-item chunks), the token whose interval contains u * kept mass.
+     Ties at the threshold are all kept, top-k may keep more than k tokens if the k-th value repeats.
+
+Uniform floats use the top 23 bits: (x >> 9) + 0.5 scaled by 2^-23. Every step is exact in float, so the result lies
+on a uniform lattice in [2^-24, 1 - 2^-24], never 0 or 1: log(u) is finite and FillUniform never returns hi.
+*/
+
+struct Philox4 {
+    uint32_t v[4];
+};
+
+// Host and device.
+inline Philox4 Philox4x32(uint64_t counter, uint64_t stream, uint64_t seed) {
+    constexpr uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u, W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+    uint32_t c0 = uint32_t(counter), c1 = uint32_t(counter >> 32), c2 = uint32_t(stream), c3 = uint32_t(stream >> 32);
+    uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+    for (int round = 0; round < 10; ++round) {
+        const uint64_t p0 = uint64_t(M0) * c0, p1 = uint64_t(M1) * c2;
+        const uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0, n1 = uint32_t(p1);
+        const uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1, n3 = uint32_t(p0);
+        c0 = n0, c1 = n1, c2 = n2, c3 = n3;
+        k0 += W0;
+        k1 += W1;
+    }
+    return {{c0, c1, c2, c3}};
+}
+
+inline float ToUniform(uint32_t x) { return (float(x >> 9) + 0.5f) * 0x1p-23f; }
+
+// Order-preserving map float -> uint32: a < b  <=>  Key(a) < Key(b).
+inline uint32_t Key(float f) {
+    const uint32_t bits = sycl::bit_cast<uint32_t>(f);
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+constexpr int WG = 256;
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Fill kernels, one work-item per Philox call (4 values).
+// ---------------------------------------------------------------------------------------------------------------------
+template <typename T, typename Fn>
+sycl::event FillWith(sycl::queue &q, T *out, size_t n, uint64_t seed, uint64_t stream, Fn fn) {
+    return q.parallel_for(sycl::range<1>((n + 3) / 4), [=](sycl::id<1> id) {
+        const size_t c = id[0];
+        const Philox4 r = Philox4x32(c, stream, seed);
+        T v[4];
+        fn(r, v);
+        for (int j = 0; j < 4; ++j)
+            if (c * 4 + j < n)
+                out[c * 4 + j] = v[j];
+    });
+}
+
+sycl::event FillUniform(sycl::queue &q, float *out, size_t n, uint64_t seed, uint64_t stream, float lo = 0.0f,
+                        float hi = 1.0f) {
+    return FillWith(q, out, n, seed, stream, [=](const Philox4 &r, float *v) {
+        for (int j = 0; j < 4; ++j)
+            v[j] = lo + (hi - lo) * ToUniform(r.v[j]);
+    });
+}
+
+// Box-Muller, every pair of uniforms gives two normals.
+sycl::event FillNormal(sycl::queue &q, float *out, size_t n, uint64_t seed, uint64_t stream, float mean = 0.0f,
+                       float stddev = 1.0f) {
+    return FillWith(q, out, n, seed, stream, [=](const Philox4 &r, float *v) {
+        for (int j = 0; j < 4; j += 2) {
+            const float radius = sycl::sqrt(-2.0f * sycl::log(ToUniform(r.v[j])));
+            const float theta = 6.28318530718f * ToUniform(r.v[j + 1]);
+            v[j] = mean + stddev * radius * sycl::cos(theta);
+            v[j + 1] = mean + stddev * radius * sycl::sin(theta);
+        }
+    });
+}
+
+sycl::event FillBernoulli(sycl::queue &q, uint8_t *out, size_t n, uint64_t seed, uint64_t stream, float p) {
+    return FillWith(q, out, n, seed, stream, [=](const Philox4 &r, uint8_t *v) {
+        for (int j = 0; j < 4; ++j)
+            v[j] = ToUniform(r.v[j]) < p;
+    });
+}
+
+// y[i] = x[i] / (1 - p) with probability 1 - p, else 0. mask[i] = 1 if kept.
+sycl::event Dropout(sycl::queue &q, const float *x, float *y, uint8_t *mask, size_t n, float p, uint64_t seed,
+                    uint64_t stream) {
+    const float scale = 1.0f / (1.0f - p);
+    return q.parallel_for(sycl::range<1>((n + 3) / 4), [=](sycl::id<1> id) {
+        const size_t c = id[0];
+        const Philox4 r = Philox4x32(c, stream, seed);
+        for (int j = 0; j < 4; ++j) {
+            const size_t i = c * 4 + j;
+            if (i >= n)
+                break;
+            const bool keep = ToUniform(r.v[j]) >= p;
+            mask[i] = keep;
+            y[i] = keep ? x[i] * scale : 0.0f;
+        }
+    });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Top-k / top-p sampling
+// ---------------------------------------------------------------------------------------------------------------------
+struct SamplingParams {
+    float temperature = 1.0f;
+    int top_k = 0;      // 0 = off
+    float top_p = 1.0f; // 1 = off
+};
+
+// logits[B][V] -> tokens[B]. Row b draws its uniform from Philox(b, stream, seed).
+sycl::event SampleTopKTopP(sycl::queue &q, const float *logits, int *tokens, int B, int V, SamplingParams sp,
+                           uint64_t seed, uint64_t stream) {
+    const int chunk = (V + WG - 1) / WG; // contiguous logits per work-item
+    return q.parallel_for(sycl::nd_range<1>(size_t(B) * WG, WG), [=](sycl::nd_item<1> item) {
+        auto g = item.get_group();
+        const int b = item.get_group(0);
+        const int lid = item.get_local_id(0);
+        const float *row = logits + size_t(b) * V;
+        const int begin = std::min(V, lid * chunk), end = std::min(V, begin + chunk);
+        const float inv_t = 1.0f / sp.temperature;
+
+        float mx = -INFINITY;
+        for (int i = begin; i < end; ++i)
+            mx = sycl::max(mx, row[i]);
+        mx = sycl::reduce_over_group(g, mx, sycl::maximum<float>());
+        auto weight = [=](float l) { return sycl::exp((l - mx) * inv_t); };
+
+        // Largest key K with pred(K), built from the MSB down, pred must be monotone (true ... true false ... false).
+        auto search = [&](auto pred) {
+            uint32_t K = 0;
+            for (int bit = 31; bit >= 0; --bit) {
+                const uint32_t cand = K | (1u << bit);
+                if (pred(cand))
+                    K = cand;
+            }
+            return K;
+        };
+        auto count_ge = [&](uint32_t K) {
+            int cnt = 0;
+            for (int i = begin; i < end; ++i)
+                cnt += Key(row[i]) >= K;
+            return sycl::reduce_over_group(g, cnt, sycl::plus<int>());
+        };
+        auto mass_ge = [&](uint32_t K) {
+            float m = 0.0f;
+            for (int i = begin; i < end; ++i)
+                m += Key(row[i]) >= K ? weight(row[i]) : 0.0f;
+            return sycl::reduce_over_group(g, m, sycl::plus<float>());
+        };
+
+        // Top-k: K = key of the k-th largest logit.
+        const uint32_t k_key = sp.top_k > 0 && sp.top_k < V ? search([&](uint32_t K) { return count_ge(K) >= sp.top_k; }) : 0u;
+        // Top-p: the smallest set of largest logits (inside the top-k set) with at least top_p of its mass.
+        const float k_mass = mass_ge(k_key);
+        uint32_t cut = k_key;
+        if (sp.top_p < 1.0f) {
+            const float target = sp.top_p * k_mass;
+            cut = sycl::max(k_key, search([&](uint32_t K) { return mass_ge(sycl::max(K, k_key)) >= target; }));
+        }
+
+        // Categorical sample over {i : Key(row[i]) >= cut} in index order.
+        float local = 0.0f;
+        int last = -1;
+        for (int i = begin; i < end; ++i)
+            if (Key(row[i]) >= cut) {
+                local += weight(row[i]);
+                last = i;
+            }
+        const float prefix = sycl::exclusive_scan_over_group(g, local, sycl::plus<float>());
+        const float total = sycl::reduce_over_group(g, local, sycl::plus<float>());
+        const float u = ToUniform(Philox4x32(uint64_t(b), stream, seed).v[0]) * total;
+        int found = -1;
+        if (local > 0.0f && u >= prefix && u < prefix + local) {
+            float acc = prefix;
+            for (int i = begin; i < end && found < 0; ++i)
+                if (Key(row[i]) >= cut) {
+                    acc += weight(row[i]);
+                    if (u < acc)
+                        found = i;
+                }
+            if (found < 0) // rounding inside the chunk
+                found = last;
+        }
+        found = sycl::reduce_over_group(g, found, sycl::maximum<int>());
+        last = sycl::reduce_over_group(g, last, sycl::maximum<int>());
+        if (lid == 0)
+            tokens[b] = found >= 0 ? found : last; // u rounded up to the total
+    });
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example
+// ---------------------------------------------------------------------------------------------------------------------
+int main() {
+    sycl::queue q;
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    constexpr size_t N = 1 << 22;
+    constexpr uint64_t SEED = 0x5EEDULL;
+    float *d_f = sycl::malloc_device<float>(N, q);
+    float *d_g = sycl::malloc_device<float>(N, q);
+    uint8_t *d_m = sycl::malloc_device<uint8_t>(N, q);
+    std::vector<float> f(N);
+    std::vector<uint8_t> m(N);
+
+    {
+        // Bit-exact against the host Philox, strictly inside (0, 1) including the extreme inputs, mean 0.5, variance 1/12.
+        FillUniform(q, d_f, N, SEED, 0).wait();
+        q.memcpy(f.data(), d_f, N * sizeof(float)).wait();
+        int mismatches = 0;
+        double sum = 0.0, sq = 0.0;
+        mismatches += ToUniform(0u) != 0x1p-24f || ToUniform(0xFFFFFFFFu) != 1.0f - 0x1p-24f;
+        for (size_t i = 0; i < N; ++i) {
+            mismatches += f[i] != ToUniform(Philox4x32(i / 4, 0, SEED).v[i % 4]) || !(f[i] > 0.0f && f[i] < 1.0f);
+            sum += f[i];
+            sq += double(f[i]) * f[i];
+        }
+        const double mean = sum / N;
+        std::cout << "uniform:   mean " << mean << ", var " << sq / N - mean * mean << " (1/12 = " << 1.0 / 12
+                  << "), host mismatches: " << mismatches << std::endl;
+    }
+    {
+        FillNormal(q, d_f, N, SEED, 1, 0.0f, 1.0f).wait();
+        q.memcpy(f.data(), d_f, N * sizeof(float)).wait();
+        double sum = 0.0, sq = 0.0;
+        for (float v : f) {
+            sum += v;
+            sq += double(v) * v;
+        }
+        const double mean = sum / N;
+        std::cout << "normal:    mean " << mean << ", var " << sq / N - mean * mean << std::endl;
+    }
+    {
+        FillBernoulli(q, d_m, N, SEED, 2, 0.3f).wait();
+        q.memcpy(m.data(), d_m, N).wait();
+        std::cout << "bernoulli: p = 0.3, observed " << double(std::accumulate(m.begin(), m.end(), size_t(0))) / N
+                  << std::endl;
+    }
+    {
+        FillUniform(q, d_f, N, SEED, 3, -1.0f, 1.0f).wait();
+        Dropout(q, d_f, d_g, d_m, N, 0.1f, SEED, 4).wait();
+        std::vector<float> x(N), y(N);
+        q.memcpy(x.data(), d_f, N * sizeof(float));
+        q.memcpy(y.data(), d_g, N * sizeof(float));
+        q.memcpy(m.data(), d_m, N);
+        q.wait();
+        int errors = 0;
+        size_t kept = 0;
+        for (size_t i = 0; i < N; ++i) {
+            kept += m[i];
+            errors += y[i] != (m[i] ? x[i] * (1.0f / 0.9f) : 0.0f);
+        }
+        std::cout << "dropout:   p = 0.1, kept " << double(kept) / N << ", errors: " << errors << std::endl;
+    }
+
+    {
+        // B rows with identical logits, sampled with RUNS streams: the token histogram must match the filtered,
+        // renormalized softmax. Zipf-like logits, a few tokens carry most of the mass.
+        constexpr int B = 2048, V = 32000, RUNS = 16;
+        std::vector<float> row(V);
+        for (int i = 0; i < V; ++i)
+            row[i] = -1.5f * std::log(1.0f + float(i)) + 0.3f * ToUniform(Philox4x32(i, 0, 7).v[0]);
+        float *d_logits = sycl::malloc_device<float>(size_t(B) * V, q);
+        int *d_tokens = sycl::malloc_device<int>(B, q);
+        for (int b = 0; b < B; ++b)
+            q.memcpy(d_logits + size_t(b) * V, row.data(), V * sizeof(float));
+        q.wait();
+
+        for (SamplingParams sp : {SamplingParams{1.0f, 50, 1.0f}, SamplingParams{0.8f, 0, 0.9f}, SamplingParams{1.0f, 40, 0.5f}}) {
+            std::vector<int> tokens(size_t(B) * RUNS);
+            for (int run = 0; run < RUNS; ++run) {
+                SampleTopKTopP(q, d_logits, d_tokens, B, V, sp, SEED, 5 + run).wait();
+                q.memcpy(tokens.data() + size_t(run) * B, d_tokens, B * sizeof(int)).wait();
+            }
+
+            // Host reference: sort, cut top-k, then the smallest prefix with top_p of the kept mass.
+            std::vector<int> order(V);
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](int a, int c) { return row[a] > row[c]; });
+            const float mx = row[order[0]];
+            size_t keep = sp.top_k > 0 ? size_t(sp.top_k) : size_t(V);
+            while (keep < size_t(V) && row[order[keep]] == row[order[keep - 1]])
+                ++keep; // ties at the threshold are kept
+            double k_mass = 0.0;
+            for (size_t i = 0; i < keep; ++i)
+                k_mass += std::exp((row[order[i]] - mx) / sp.temperature);
+            if (sp.top_p < 1.0f) {
+                double acc = 0.0;
+                size_t p_keep = 0;
+                while (p_keep < keep && acc < sp.top_p * k_mass)
+                    acc += std::exp((row[order[p_keep++]] - mx) / sp.temperature);
+                keep = p_keep;
+            }
+            std::vector<double> expect(V, 0.0);
+            double mass = 0.0;
+            for (size_t i = 0; i < keep; ++i)
+                mass += expect[order[i]] = std::exp((row[order[i]] - mx) / sp.temperature);
+
+            std::vector<double> seen(V, 0.0);
+            int outside = 0;
+            for (int t : tokens) {
+                outside += t < 0 || t >= V || expect[t] == 0.0;
+                if (t >= 0 && t < V)
+                    seen[t] += 1.0 / tokens.size();
+            }
+            double tv = 0.0;
+            for (int i = 0; i < V; ++i)
+                tv += std::abs(seen[i] - expect[i] / mass);
+            std::cout << "sample T=" << sp.temperature << " top_k=" << sp.top_k << " top_p=" << sp.top_p << ": "
+                      << keep << " tokens kept, outside the set: " << outside << ", total variation: " << tv / 2
+                      << std::endl;
+        }
+        sycl::free(d_logits, q);
+        sycl::free(d_tokens, q);
+    }
+
+    sycl::free(d_f, q);
+    sycl::free(d_g, q);
+    sycl::free(d_m, q);
+    return 0;
+}
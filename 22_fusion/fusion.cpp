@@ -0,0 +1,294 @@
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+/*
+Keys:
+  1) Expression templates: a chain like
+         add(x, bias) | silu | mul(gate) | reduce_sum
+     is a C++ type, Reduction<Chain<Chain<Chain<Input<float>, AddOp<float>>, SiluOp>, MulOp<float>>>.
+     Building it costs nothing, it only stores the input pointers.
+  2) Fused<W>(q, expr, out, n) lowers the whole chain to ONE kernel: every work-item loads W elements of every input
+     with one sycl::vec<T, W> load, runs all stages in registers, and stores (or reduces) once.
+     No intermediate buffers, every input is read once and the output is written once.
+  3) Specialized on the element type T (float, sycl::half, ...) and on the vector width W, default W = 16 bytes / sizeof(T).
+     A reduction accumulates in float.
+  4) Unfused<W>(...) runs the same chain one stage per kernel through temporary buffers, the baseline.
+
+Traffic for n elements of float, as run by the benchmark:
+                                  unfused                                  fused
+  add | silu | mul                add 3n + silu 2n + mul 3n = 8n, 3 kernels   x, bias, gate, y = 4n, 1 kernel
+  add | silu | mul | reduce_sum   8n + sum 1n = 9n, 4 kernels                 x, bias, gate    = 3n, 1 kernel
+
+  6_exp_mul is the same pattern: one kernel fills `data`, a second kernel reads it back for the SiLU.
+
+Requirements: the input pointers are USM allocations (aligned for vector loads), all inputs have n elements.
+*/
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Expressions (produce values) and stages (transform values)
+// ---------------------------------------------------------------------------------------------------------------------
+template <typename T, int W>
+sycl::vec<T, W> Load(const T *p, size_t i) {
+    return *reinterpret_cast<const sycl::vec<T, W> *>(p + i);
+}
+
+template <typename T>
+struct Input {
+    using value_type = T;
+    static constexpr bool is_expr = true;
+    const T *p;
+    template <int W>
+    sycl::vec<T, W> eval(size_t i) const { return Load<T, W>(p, i); }
+};
+
+template <typename Src, typename Op>
+struct Chain {
+    using value_type = typename Src::value_type;
+    static constexpr bool is_expr = true;
+    Src src;
+    Op op;
+    template <int W>
+    sycl::vec<value_type, W> eval(size_t i) const { return op.template apply<value_type, W>(src.template eval<W>(i), i); }
+};
+
+template <typename Src>
+struct Reduction {
+    Src src;
+};
+
+template <typename T>
+struct AddOp {
+    static constexpr bool is_stage = true;
+    const T *b;
+    template <typename U, int W>
+    sycl::vec<U, W> apply(sycl::vec<U, W> v, size_t i) const { return v + Load<T, W>(b, i); }
+};
+
+template <typename T>
+struct MulOp {
+    static constexpr bool is_stage = true;
+    const T *b;
+    template <typename U, int W>
+    sycl::vec<U, W> apply(sycl::vec<U, W> v, size_t i) const { return v * Load<T, W>(b, i); }
+};
+
+struct ScaleOp {
+    static constexpr bool is_stage = true;
+    float alpha;
+    template <typename U, int W>
+    sycl::vec<U, W> apply(sycl::vec<U, W> v, size_t) const { return v * U(alpha); }
+};
+
+struct SiluOp {
+    static constexpr bool is_stage = true;
+    template <typename U, int W>
+    sycl::vec<U, W> apply(sycl::vec<U, W> v, size_t) const { return v / (U(1) + sycl::exp(-v)); }
+};
+
+struct ReluOp {
+    static constexpr bool is_stage = true;
+    template <typename U, int W>
+    sycl::vec<U, W> apply(sycl::vec<U, W> v, size_t) const { return sycl::fmax(v, sycl::vec<U, W>(U(0))); }
+};
+
+struct ReduceSumTag {};
+
+template <typename T, typename = void> struct IsExpr : std::false_type {};
+template <typename T> struct IsExpr<T, std::void_t<decltype(T::is_expr)>> : std::true_type {};
+template <typename T, typename = void> struct IsStage : std::false_type {};
+template <typename T> struct IsStage<T, std::void_t<decltype(T::is_stage)>> : std::true_type {};
+
+template <typename T> Input<T> input(const T *x) { return {x}; }
+template <typename T> Chain<Input<T>, AddOp<T>> add(const T *x, const T *b) { return {{x}, {b}}; }
+template <typename T> MulOp<T> mul(const T *b) { return {b}; }
+inline ScaleOp scale(float alpha) { return {alpha}; }
+inline constexpr SiluOp silu{};
+inline constexpr ReluOp relu{};
+inline constexpr ReduceSumTag reduce_sum{};
+
+template <typename E, typename Op, std::enable_if_t<IsExpr<E>::value && IsStage<Op>::value, int> = 0>
+Chain<E, Op> operator|(E e, Op op) {
+    return {e, op};
+}
+
+template <typename E, std::enable_if_t<IsExpr<E>::value, int> = 0>
+Reduction<E> operator|(E e, ReduceSumTag) {
+    return {e};
+}
+
+template <typename T>
+constexpr int DefaultWidth = 16 / sizeof(T);
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Lowering
+// ---------------------------------------------------------------------------------------------------------------------
+
+// out[0, n) = expr, one work-item per W elements, the last work-item takes the n % W tail one by one.
+template <int W = 0, typename E, typename T = typename E::value_type, std::enable_if_t<IsExpr<E>::value, int> = 0>
+sycl::event Fused(sycl::queue &q, E expr, T *out, size_t n) {
+    constexpr int VW = W ? W : DefaultWidth<T>;
+    return q.parallel_for(sycl::range<1>((n + VW - 1) / VW), [=](sycl::id<1> id) {
+        const size_t i = id[0] * VW;
+        if (i + VW <= n) {
+            *reinterpret_cast<sycl::vec<T, VW> *>(out + i) = expr.template eval<VW>(i);
+        } else {
+            for (size_t j = i; j < n; ++j)
+                out[j] = expr.template eval<1>(j)[0];
+        }
+    });
+}
+
+// *out = sum(expr[0, n)) in float, one kernel with sycl::reduction.
+template <int W = 0, typename E, typename T = typename E::value_type>
+sycl::event Fused(sycl::queue &q, Reduction<E> red, float *out, size_t n) {
+    constexpr int VW = W ? W : DefaultWidth<T>;
+    const E expr = red.src;
+    return q.submit([&](sycl::handler &h) {
+        auto sum = sycl::reduction(out, sycl::plus<float>(), sycl::property::reduction::initialize_to_identity{});
+        h.parallel_for(sycl::range<1>((n + VW - 1) / VW), sum, [=](sycl::id<1> id, auto &acc) {
+            const size_t i = id[0] * VW;
+            float s = 0.0f;
+            if (i + VW <= n) {
+                const auto v = expr.template eval<VW>(i).template convert<float>();
+                for (int k = 0; k < VW; ++k)
+                    s += v[k];
+            } else {
+                for (size_t j = i; j < n; ++j)
+                    s += float(expr.template eval<1>(j)[0]);
+            }
+            acc += s;
+        });
+    });
+}
+
+// The baseline: one kernel per stage. Scratch is allocated once, outside of the timed region.
+template <typename T>
+struct Scratch {
+    sycl::queue &q;
+    T *buf[2];
+    Scratch(sycl::queue &q, size_t n) : q(q), buf{sycl::malloc_device<T>(n, q), sycl::malloc_device<T>(n, q)} {}
+    ~Scratch() {
+        sycl::free(buf[0], q);
+        sycl::free(buf[1], q);
+    }
+};
+
+// Evaluates `c` one stage per kernel and returns where the result is. The stages ping-pong between `dst` and `spare`,
+// the last stage always writes `dst`, so a chain of any length needs one buffer besides its output.
+template <int W, typename T>
+const T *Stages(sycl::queue &, Input<T> in, T *, T *, size_t) {
+    return in.p;
+}
+
+template <int W, typename Src, typename Op, typename T = typename Src::value_type>
+const T *Stages(sycl::queue &q, Chain<Src, Op> c, T *dst, T *spare, size_t n) {
+    const T *src = Stages<W>(q, c.src, spare, dst, n);
+    Fused<W>(q, Chain<Input<T>, Op>{{src}, c.op}, dst, n);
+    return dst;
+}
+
+// `q` must be in-order, the stages depend on each other through the scratch buffers.
+template <int W = 0, typename E, typename T = typename E::value_type, std::enable_if_t<IsExpr<E>::value, int> = 0>
+void Unfused(sycl::queue &q, E expr, T *out, size_t n, Scratch<T> &scratch) {
+    const T *r = Stages<W>(q, expr, out, scratch.buf[0], n);
+    if (r != out)
+        q.memcpy(out, r, n * sizeof(T));
+    q.wait();
+}
+
+template <int W = 0, typename E, typename T = typename E::value_type>
+void Unfused(sycl::queue &q, Reduction<E> red, float *out, size_t n, Scratch<T> &scratch) {
+    const T *r = Stages<W>(q, red.src, scratch.buf[0], scratch.buf[1], n);
+    Fused<W>(q, input(r) | reduce_sum, out, n).wait();
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------------------------------------------------
+template <typename Fn>
+double TimeUs(Fn &&fn, int iters = 10) {
+    fn();
+    auto tag_0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+        fn();
+    auto tag_1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(tag_1 - tag_0).count() / iters;
+}
+
+template <typename T>
+void Run(sycl::queue &q, const char *type, size_t n, double tol) {
+    std::vector<T> x(n), bias(n), gate(n), y(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = T(std::sin(0.001f * float(i % 10007)));
+        bias[i] = T(0.25f * std::cos(0.01f * float(i % 101)));
+        gate[i] = T(1.0f + 0.5f * std::sin(0.003f * float(i % 997)));
+    }
+    std::vector<double> ref(n);
+    double ref_sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const double a = double(x[i]) + double(bias[i]);
+        ref[i] = a / (1.0 + std::exp(-a)) * double(gate[i]);
+        ref_sum += ref[i];
+    }
+
+    T *d_x = sycl::malloc_device<T>(n, q), *d_b = sycl::malloc_device<T>(n, q), *d_g = sycl::malloc_device<T>(n, q);
+    T *d_y = sycl::malloc_device<T>(n, q);
+    float *d_sum = sycl::malloc_device<float>(1, q);
+    q.memcpy(d_x, x.data(), n * sizeof(T));
+    q.memcpy(d_b, bias.data(), n * sizeof(T));
+    q.memcpy(d_g, gate.data(), n * sizeof(T)).wait();
+
+    const auto chain = add<T>(d_x, d_b) | silu | mul<T>(d_g);
+    const auto reduced = chain | reduce_sum;
+
+    auto check = [&] {
+        q.memcpy(y.data(), d_y, n * sizeof(T)).wait();
+        int errors = 0;
+        for (size_t i = 0; i < n; ++i)
+            errors += std::abs(double(y[i]) - ref[i]) > tol * (1.0 + std::abs(ref[i]));
+        return errors;
+    };
+    auto check_sum = [&] {
+        float sum;
+        q.memcpy(&sum, d_sum, sizeof(float)).wait();
+        return std::abs(sum - ref_sum) / std::abs(ref_sum);
+    };
+    const double gb = 4.0 * n * sizeof(T) / 1e3; // x, bias, gate, y; per usec -> GB/s
+
+    Scratch<T> scratch(q, n);
+    double us = TimeUs([&] { Unfused(q, chain, d_y, n, scratch); });
+    std::cout << type << " add|silu|mul unfused:          " << us << " usec, " << gb / us
+              << " GB/s effective, errors: " << check() << std::endl;
+    us = TimeUs([&] { Fused<1>(q, chain, d_y, n).wait(); });
+    std::cout << type << " add|silu|mul fused W=1:        " << us << " usec, " << gb / us
+              << " GB/s effective, errors: " << check() << std::endl;
+    us = TimeUs([&] { Fused(q, chain, d_y, n).wait(); });
+    std::cout << type << " add|silu|mul fused W=" << DefaultWidth<T> << ":        " << us << " usec, " << gb / us
+              << " GB/s effective, errors: " << check() << std::endl;
+    us = TimeUs([&] { Unfused(q, reduced, d_sum, n, scratch); });
+    std::cout << type << " add|silu|mul|sum unfused:      " << us << " usec, rel error: " << check_sum() << std::endl;
+    us = TimeUs([&] { Fused(q, reduced, d_sum, n).wait(); });
+    std::cout << type << " add|silu|mul|sum fused W=" << DefaultWidth<T> << ":    " << us << " usec, rel error: " << check_sum()
+              << std::endl;
+
+    sycl::free(d_x, q);
+    sycl::free(d_b, q);
+    sycl::free(d_g, q);
+    sycl::free(d_y, q);
+    sycl::free(d_sum, q);
+}
+
+int main() {
+    sycl::queue q{sycl::property::queue::in_order()};
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    constexpr size_t N = (1 << 24) + 3; // the + 3 exercises the tail
+    Run<float>(q, "f32", N, 1e-5);
+    if (q.get_device().has(sycl::aspect::fp16))
+        Run<sycl::half>(q, "f16", N, 1e-2);
+    return 0;
+}
@@ -1,7 +1,8 @@
 #include <CL/sycl.hpp>
 #include <iostream>
 
-#define FLT_MIN 1e9
+// Inputs are small integers, so host and device results are expected to match almost exactly.
+constexpr float kTolerance = 1e-6f;
 
 inline int OneDimArrayFMA(const sycl::device &device)
 {
@@ -46,14 +47,17 @@ inline int OneDimArrayFMA(const sycl::device &device)
     }
 
     // check for correctness
+    int errors = 0;
     for (size_t i = 0; i < length; ++i)
     {
-        if (std::abs(h_Z[i] - correct) > FLT_MIN)
+        if (std::abs(h_Z[i] - correct) > kTolerance)
         {
             std::cout << "error Index:" << i << ","
                       << "h_Z[i] value: " << h_Z[i] << std::endl;
+            ++errors;
         }
     }
+    return errors;
 }
 
 inline int TwoDimArrayMatmul(const sycl::device &device)
@@ -132,12 +136,14 @@ inline int TwoDimArrayMatmul(const sycl::device &device)
     }
 
     // check for correctness
+    int errors = 0;
     for (size_t i = 0; i < M * N; ++i)
     {
-        if (std::abs(res_buffer[i] - host_result[i]) > FLT_MIN)
+        if (std::abs(res_buffer[i] - host_result[i]) > kTolerance)
         {
             std::cout << "error Index:" << i << ","
                       << "res_buffer[i] value: " << res_buffer[i] << std::endl;
+            ++errors;
         }
     }
 
@@ -145,12 +151,14 @@ inline int TwoDimArrayMatmul(const sycl::device &device)
     free(host_matrix2);
     free(host_result);
     free(res_buffer);
+    return errors;
 }
 
 int main()
 {
     auto devices = sycl::default_selector{}.select_device();
-    OneDimArrayFMA(devices);
-    TwoDimArrayMatmul(devices);
-    return 0;
+    int errors = OneDimArrayFMA(devices);
+    errors += TwoDimArrayMatmul(devices);
+    std::cout << "errors: " << errors << std::endl;
+    return errors == 0 ? 0 : 1;
 }
@@ -1,6 +1,9 @@
 #include <CL/sycl.hpp>
 #include <iostream>
 #include <memory>
+#include <vector>
+
+#include "host_reference.hpp"
 
 // constexpr int N = 128*1024;
 constexpr int N = 8;
@@ -16,6 +19,9 @@ int main() {
     for (int i = 0; i < N; i++)
         std::cout << data[i] << "\n";
 
+    std::vector<float> ref(N);
+    host_ref::Silu(N, data, ref.data());
+
     q.submit([&](sycl::handler &h) {
         h.parallel_for(N, [=](auto i) {
             data[i] = data[i] * float(1.0) / (float(1.0) + sycl::native::exp(-data[i]));
@@ -25,7 +31,11 @@ int main() {
     for (int i = 0; i < N; i++)
         std::cout << data[i] << "\n";
 
+    // native::exp trades accuracy for speed, so the bound is looser than sycl::exp would need.
+    auto r = Compare(ref.data(), data, N, {1e-6f, 1e-4f, 64});
+    std::cout << (r.ok() ? "PASS" : "FAIL") << ", max_ulp: " << r.max_ulp << ", mismatches: " << r.mismatches << "\n";
+
     sycl::free(data, q);
 
-    return 0;
+    return r.ok() ? 0 : 1;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <vector>
 
+#include "host_reference.hpp"
+
 /*
 Keys:
 一、基本并行内核的功能通过 range、id 和 item 类提供
@@ -77,7 +79,7 @@ const int sequence_length = 4;
 const int head_num = 4;
 const int head_size = 2;
 
-void Add(sycl::queue &q, std::vector<float> &a, std::vector<float> &b, std::vector<float> &c) {
+bool Add(sycl::queue &q, std::vector<float> &a, std::vector<float> &b, std::vector<float> &c) {
     sycl::buffer<float, 1> bufferA(a.data(), sycl::range<1>(a.size()));
     sycl::buffer<float, 1> bufferB(b.data(), sycl::range<1>(b.size()));
     sycl::buffer<float, 1> bufferC(c.data(), sycl::range<1>(c.size()));
@@ -87,7 +89,7 @@ void Add(sycl::queue &q, std::vector<float> &a, std::vector<float> &b, std::vect
     int iStride = 4096;
     int elementsPerThread = 8;
     float *device_data = sycl::malloc_device<float>(cols, q);
-    q.fill(device_data, 1.0f, cols);
+    q.fill(device_data, 1.0f, cols).wait();
     sycl::buffer<float> bufSum {0.0f}; 
     sycl::buffer<float> part_sum(sycl::range<1>(512));
 
@@ -168,7 +170,9 @@ void Add(sycl::queue &q, std::vector<float> &a, std::vector<float> &b, std::vect
         auto out = sycl::stream(10240, 7680, cgh);
         auto accessorA = bufferA.get_access<sycl::access::mode::read>(cgh);
         auto part_sum_data = part_sum.get_access<sycl::access::mode::read_write>(cgh);
-        cgh.parallel_for(sycl::nd_range<1>(sycl::range<1>(512), sycl::range<1>(1)), [=](sycl::nd_item<1> item_ct1) {
+        auto sum = bufSum.get_access<sycl::access::mode::write>(cgh);
+        // One work-group of 512: the barriers below only synchronize work-items of the same work-group.
+        cgh.parallel_for(sycl::nd_range<1>(sycl::range<1>(512), sycl::range<1>(512)), [=](sycl::nd_item<1> item_ct1) {
             for (int row = 0; row < rows; ++row) {
                 int idx_col = item_ct1.get_global_id(0);
                 if (idx_col < 512) {
@@ -228,6 +232,7 @@ void Add(sycl::queue &q, std::vector<float> &a, std::vector<float> &b, std::vect
                 if (idx_col == 0) {
                     float ss = part_sum_data[0] + part_sum_data[1] + part_sum_data[2] + part_sum_data[3] + 
                                part_sum_data[4] + part_sum_data[5] + part_sum_data[6] + part_sum_data[7];
+                    sum[0] = ss;
                     out << "ss: " << ss  << sycl::endl;
                     // for (int i = 0; i < 32; ++i)
                     //     out << "0 part_sum_data[" << i << "]: " << part_sum_data[i]  << sycl::endl;
@@ -240,6 +245,17 @@ void Add(sycl::queue &q, std::vector<float> &a, std::vector<float> &b, std::vect
             }
         });
     }).wait();
+
+    // Reference over the values the kernel actually read.
+    std::vector<float> host_data(cols);
+    q.memcpy(host_data.data(), device_data, cols * sizeof(float)).wait();
+    float ref = host_ref::SumOfSquares(cols, host_data.data());
+    float ss = bufSum.get_host_access()[0];
+    auto r = Compare(&ref, &ss, 1, {0.0f, 1e-5f, 0});
+    std::cout << "ss check: " << (r.ok() ? "PASS" : "FAIL") << ", ref: " << ref << ", sycl: " << ss << "\n";
+
+    sycl::free(device_data, q);
+    return r.ok();
 }
 
 int main() {
@@ -262,11 +278,11 @@ int main() {
     for (int i = 0; i < sequence_length * head_num * head_size; ++i)
         a[i] = b[i] = i * 0.11;
 
-    Add(q, a, b, c);
+    bool ok = Add(q, a, b, c);
 
     for (int i = 0; i < sequence_length * head_num * head_size; ++i)
         std::cout << c[i] << " ";
     std::cout << std::endl;
 
-    return 0;
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,322 @@
+#include <CL/sycl.hpp>
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "host_reference.hpp"
+
+/*
+Keys:
+  1) Host reference: every kernel has a parallel + vectorized CPU implementation (`#pragma omp parallel for simd`).
+  2) Comparator: results are checked with an ULP / relative / absolute tolerance instead of a fixed threshold.
+  3) Harness: each kernel is run at several sizes, reporting PASS/FAIL, the worst error and the SYCL-vs-host speedup.
+  4) Fallback: if no SYCL device can be created, the host path still runs so the numbers are never missing.
+
+Why ULP:
+  • Floating point results of a device kernel are almost never bit-identical to the host, the order of
+    accumulation (reduction tree, FMA contraction, native:: math) is different.
+  • A pure absolute threshold is either too loose for small values or too tight for large values,
+    a threshold like 1e9 can never fail.
+  • ULP (units in the last place) measures how many representable floats lie between two values,
+    so "4 ulp" means the same thing for 1e-6 and for 1e+6.
+
+      float bits  ──►  signed-magnitude  ──►  two's complement ordering  ──►  |a - b| = ulp distance
+
+  | Kernel    | Host reference                          | SYCL kernel                                  |
+  | --------- | --------------------------------------- | -------------------------------------------- |
+  | axpy      | omp parallel for simd                   | parallel_for(range<1>)                       |
+  | matmul    | omp parallel for + simd over N          | parallel_for(range<2>)                       |
+  | reduction | omp parallel for simd reduction(+)      | sycl::reduction                              |
+  | silu      | omp parallel for simd                   | parallel_for(range<1>)                       |
+  | rmsnorm   | omp parallel for + simd reduction / row | nd_range, one work-group per row, reduce_over_group |
+*/
+
+// ---------------------------------------------------------------------------------------------------------------------
+// SYCL backend, all pointers are device USM
+// ---------------------------------------------------------------------------------------------------------------------
+namespace sycl_ref {
+
+sycl::event Axpy(sycl::queue &q, size_t n, float a, const float *x, const float *y, float *z) {
+    return q.parallel_for(sycl::range<1>(n), [=](sycl::id<1> i) {
+        z[i] += a * x[i] + y[i];
+    });
+}
+
+sycl::event Matmul(sycl::queue &q, size_t M, size_t K, size_t N, const float *A, const float *B, float *C) {
+    return q.parallel_for(sycl::range<2>(M, N), [=](sycl::item<2> idx) {
+        size_t m = idx.get_id(0);
+        size_t n = idx.get_id(1);
+        float acc = 0.0f;
+        for (size_t k = 0; k < K; ++k)
+            acc += A[m * K + k] * B[k * N + n];
+        C[m * N + n] = acc;
+    });
+}
+
+sycl::event SumOfSquares(sycl::queue &q, size_t n, const float *x, float *sum) {
+    return q.submit([&](sycl::handler &h) {
+        auto red = sycl::reduction(sum, sycl::plus<float>(), sycl::property::reduction::initialize_to_identity{});
+        h.parallel_for(sycl::range<1>(n), red, [=](sycl::id<1> i, auto &acc) {
+            acc += x[i] * x[i];
+        });
+    });
+}
+
+sycl::event Silu(sycl::queue &q, size_t n, const float *x, float *y) {
+    return q.parallel_for(sycl::range<1>(n), [=](sycl::id<1> i) {
+        y[i] = x[i] / (1.0f + sycl::exp(-x[i]));
+    });
+}
+
+sycl::event RmsNorm(sycl::queue &q, size_t rows, size_t cols, const float *x, const float *weight, float *y, float eps) {
+    constexpr size_t wg = 256;
+    return q.parallel_for(sycl::nd_range<1>(rows * wg, wg), [=](sycl::nd_item<1> item) {
+        const size_t r = item.get_group(0);
+        const size_t lid = item.get_local_id(0);
+        const float *xr = x + r * cols;
+        float *yr = y + r * cols;
+
+        float ss = 0.0f;
+        for (size_t c = lid; c < cols; c += wg)
+            ss += xr[c] * xr[c];
+        ss = sycl::reduce_over_group(item.get_group(), ss, sycl::plus<float>());
+
+        const float scale = sycl::rsqrt(ss / cols + eps);
+        for (size_t c = lid; c < cols; c += wg)
+            yr[c] = xr[c] * scale * weight[c];
+    });
+}
+
+} // namespace sycl_ref
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Harness
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr int kIters = 5;
+
+// One warm-up run, then the average over kIters runs, in usec.
+template <typename Fn>
+double TimeUs(Fn &&fn) {
+    fn();
+    auto tag_0 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < kIters; ++i)
+        fn();
+    auto tag_1 = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(tag_1 - tag_0).count() / kIters;
+}
+
+void FillInput(std::vector<float> &v, float scale) {
+    const size_t n = v.size();
+    float *p = v.data();
+#pragma omp parallel for simd
+    for (size_t i = 0; i < n; ++i)
+        p[i] = scale * std::sin(0.11f * float(i % 4099));
+}
+
+// Upload a host vector into a new device allocation.
+float *ToDevice(sycl::queue &q, const std::vector<float> &v) {
+    float *d = sycl::malloc_device<float>(v.size(), q);
+    q.memcpy(d, v.data(), v.size() * sizeof(float)).wait();
+    return d;
+}
+
+void PrintHeader() {
+    std::cout << std::left << std::setw(10) << "kernel" << std::setw(22) << "size" << std::setw(6) << "check"
+              << std::right << std::setw(10) << "max_ulp" << std::setw(12) << "max_rel" << std::setw(14) << "host(us)"
+              << std::setw(14) << "sycl(us)" << std::setw(10) << "speedup" << std::endl;
+}
+
+void Report(const char *name, const std::string &size, const CompareResult *r, double host_us, double sycl_us) {
+    std::cout << std::left << std::setw(10) << name << std::setw(22) << size;
+    if (r == nullptr) {
+        std::cout << std::setw(6) << "-" << std::right << std::setw(10) << "-" << std::setw(12) << "-"
+                  << std::setw(14) << std::fixed << std::setprecision(1) << host_us << std::setw(14) << "-"
+                  << std::setw(10) << "-" << std::endl;
+        return;
+    }
+    std::cout << std::setw(6) << (r->ok() ? "PASS" : "FAIL") << std::right << std::setw(10) << r->max_ulp
+              << std::setw(12) << std::scientific << std::setprecision(2) << r->max_rel_err
+              << std::setw(14) << std::fixed << std::setprecision(1) << host_us << std::setw(14) << sycl_us
+              << std::setw(9) << std::setprecision(2) << host_us / sycl_us << "x" << std::endl;
+    if (!r->ok())
+        std::cout << "    " << r->mismatches << "/" << r->count << " mismatches, first at index " << r->first_bad << std::endl;
+}
+
+// Each Run* returns false if the device result does not match the host reference.
+bool RunAxpy(sycl::queue *q, size_t n) {
+    const float a = 3.0f;
+    std::vector<float> x(n), y(n), z(n), ref(n), out(n);
+    FillInput(x, 1.0f);
+    FillInput(y, 2.0f);
+    FillInput(z, 0.5f);
+
+    // z is updated in place, so every timed run starts from the same z.
+    double host_us = TimeUs([&] {
+        std::memcpy(ref.data(), z.data(), n * sizeof(float));
+        host_ref::Axpy(n, a, x.data(), y.data(), ref.data());
+    });
+    if (q == nullptr) {
+        Report("axpy", std::to_string(n), nullptr, host_us, 0.0);
+        return true;
+    }
+
+    float *d_x = ToDevice(*q, x);
+    float *d_y = ToDevice(*q, y);
+    float *d_z = ToDevice(*q, z);
+    float *d_z0 = ToDevice(*q, z);
+    double sycl_us = TimeUs([&] {
+        q->memcpy(d_z, d_z0, n * sizeof(float));
+        sycl_ref::Axpy(*q, n, a, d_x, d_y, d_z);
+        q->wait();
+    });
+    q->memcpy(out.data(), d_z, n * sizeof(float)).wait();
+
+    auto r = Compare(ref.data(), out.data(), n, {1e-6f, 1e-6f, 2});
+    Report("axpy", std::to_string(n), &r, host_us, sycl_us);
+
+    sycl::free(d_x, *q);
+    sycl::free(d_y, *q);
+    sycl::free(d_z, *q);
+    sycl::free(d_z0, *q);
+    return r.ok();
+}
+
+bool RunMatmul(sycl::queue *q, size_t M, size_t K, size_t N) {
+    std::vector<float> A(M * K), B(K * N), ref(M * N), out(M * N);
+    FillInput(A, 1.0f);
+    FillInput(B, 1.0f);
+    std::string size = std::to_string(M) + "x" + std::to_string(K) + "x" + std::to_string(N);
+
+    double host_us = TimeUs([&] { host_ref::Matmul(M, K, N, A.data(), B.data(), ref.data()); });
+    if (q == nullptr) {
+        Report("matmul", size, nullptr, host_us, 0.0);
+        return true;
+    }
+
+    float *d_A = ToDevice(*q, A);
+    float *d_B = ToDevice(*q, B);
+    float *d_C = sycl::malloc_device<float>(M * N, *q);
+    double sycl_us = TimeUs([&] { sycl_ref::Matmul(*q, M, K, N, d_A, d_B, d_C).wait(); });
+    q->memcpy(out.data(), d_C, M * N * sizeof(float)).wait();
+
+    // The error of a K-term dot product grows with K, scale the absolute tolerance with it.
+    auto r = Compare(ref.data(), out.data(), M * N, {1e-5f * K, 1e-4f, 16});
+    Report("matmul", size, &r, host_us, sycl_us);
+
+    sycl::free(d_A, *q);
+    sycl::free(d_B, *q);
+    sycl::free(d_C, *q);
+    return r.ok();
+}
+
+bool RunReduction(sycl::queue *q, size_t n) {
+    std::vector<float> x(n);
+    FillInput(x, 1.0f);
+    float ref = 0.0f, out = 0.0f;
+
+    double host_us = TimeUs([&] { ref = host_ref::SumOfSquares(n, x.data()); });
+    if (q == nullptr) {
+        Report("reduction", std::to_string(n), nullptr, host_us, 0.0);
+        return true;
+    }
+
+    float *d_x = ToDevice(*q, x);
+    float *d_sum = sycl::malloc_device<float>(1, *q);
+    double sycl_us = TimeUs([&] { sycl_ref::SumOfSquares(*q, n, d_x, d_sum).wait(); });
+    q->memcpy(&out, d_sum, sizeof(float)).wait();
+
+    auto r = Compare(&ref, &out, 1, {0.0f, 1e-4f, 0});
+    Report("reduction", std::to_string(n), &r, host_us, sycl_us);
+
+    sycl::free(d_x, *q);
+    sycl::free(d_sum, *q);
+    return r.ok();
+}
+
+bool RunSilu(sycl::queue *q, size_t n) {
+    std::vector<float> x(n), ref(n), out(n);
+    FillInput(x, 8.0f);
+
+    double host_us = TimeUs([&] { host_ref::Silu(n, x.data(), ref.data()); });
+    if (q == nullptr) {
+        Report("silu", std::to_string(n), nullptr, host_us, 0.0);
+        return true;
+    }
+
+    float *d_x = ToDevice(*q, x);
+    float *d_y = sycl::malloc_device<float>(n, *q);
+    double sycl_us = TimeUs([&] { sycl_ref::Silu(*q, n, d_x, d_y).wait(); });
+    q->memcpy(out.data(), d_y, n * sizeof(float)).wait();
+
+    auto r = Compare(ref.data(), out.data(), n, {1e-6f, 1e-5f, 4});
+    Report("silu", std::to_string(n), &r, host_us, sycl_us);
+
+    sycl::free(d_x, *q);
+    sycl::free(d_y, *q);
+    return r.ok();
+}
+
+bool RunRmsNorm(sycl::queue *q, size_t rows, size_t cols) {
+    const float eps = 1e-6f;
+    std::vector<float> x(rows * cols), w(cols), ref(rows * cols), out(rows * cols);
+    FillInput(x, 1.0f);
+    FillInput(w, 1.0f);
+    std::string size = std::to_string(rows) + "x" + std::to_string(cols);
+
+    double host_us = TimeUs([&] { host_ref::RmsNorm(rows, cols, x.data(), w.data(), ref.data(), eps); });
+    if (q == nullptr) {
+        Report("rmsnorm", size, nullptr, host_us, 0.0);
+        return true;
+    }
+
+    float *d_x = ToDevice(*q, x);
+    float *d_w = ToDevice(*q, w);
+    float *d_y = sycl::malloc_device<float>(rows * cols, *q);
+    double sycl_us = TimeUs([&] { sycl_ref::RmsNorm(*q, rows, cols, d_x, d_w, d_y, eps).wait(); });
+    q->memcpy(out.data(), d_y, rows * cols * sizeof(float)).wait();
+
+    auto r = Compare(ref.data(), out.data(), rows * cols, {1e-6f, 1e-4f, 8});
+    Report("rmsnorm", size, &r, host_us, sycl_us);
+
+    sycl::free(d_x, *q);
+    sycl::free(d_w, *q);
+    sycl::free(d_y, *q);
+    return r.ok();
+}
+
+int main() {
+    // Fall back to the host path when no SYCL device is available.
+    // In-order: RunAxpy resets z with a memcpy that the kernel must not overtake.
+    std::unique_ptr<sycl::queue> q;
+    try {
+        q = std::make_unique<sycl::queue>(sycl::default_selector_v, sycl::property::queue::in_order());
+        std::cout << "Device : " << q->get_device().get_info<sycl::info::device::name>() << "\n";
+    } catch (sycl::exception &e) {
+        std::cout << "No SYCL device (" << e.what() << "), running host reference only" << "\n";
+    }
+    std::cout << "Host threads : " << omp_get_max_threads() << "\n\n";
+
+    bool ok = true;
+    PrintHeader();
+    for (size_t n : {size_t(1) << 10, size_t(1) << 16, size_t(1) << 20, size_t(1) << 24})
+        ok &= RunAxpy(q.get(), n);
+    for (size_t n : {64, 256, 1024})
+        ok &= RunMatmul(q.get(), n, n, n);
+    for (size_t n : {size_t(1) << 10, size_t(1) << 16, size_t(1) << 20, size_t(1) << 24})
+        ok &= RunReduction(q.get(), n);
+    for (size_t n : {size_t(1) << 10, size_t(1) << 16, size_t(1) << 20, size_t(1) << 24})
+        ok &= RunSilu(q.get(), n);
+    for (size_t rows : {1, 32, 1024})
+        ok &= RunRmsNorm(q.get(), rows, 4096);
+
+    std::cout << "\n" << (ok ? "All checks passed" : "Some checks FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
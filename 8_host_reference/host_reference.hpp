@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/*
+Host reference backend and tolerance comparator, shared by the examples that validate their kernels.
+Parallelized and vectorized with OpenMP when the target links OpenMP::OpenMP_CXX, plain loops otherwise.
+Include with `target_include_directories(<target> PRIVATE ${PROJECT_SOURCE_DIR}/8_host_reference)`.
+*/
+
+struct Tolerance {
+    float abs;   // pass if |ref - out| <= abs
+    float rel;   // pass if |ref - out| <= rel * |ref|
+    int64_t ulp; // pass if ulp distance <= ulp
+};
+
+struct CompareResult {
+    size_t count = 0;
+    size_t mismatches = 0;
+    size_t first_bad = 0;
+    float max_abs_err = 0.0f;
+    float max_rel_err = 0.0f;
+    int64_t max_ulp = 0;
+
+    bool ok() const { return mismatches == 0; }
+};
+
+// Map the float bit pattern onto a monotonic integer line, so the difference is the ulp distance.
+inline int64_t UlpDistance(float a, float b) {
+    int32_t ia, ib;
+    std::memcpy(&ia, &a, sizeof(float));
+    std::memcpy(&ib, &b, sizeof(float));
+    int64_t la = ia < 0 ? int64_t(INT32_MIN) - ia : ia;
+    int64_t lb = ib < 0 ? int64_t(INT32_MIN) - ib : ib;
+    return la > lb ? la - lb : lb - la;
+}
+
+inline CompareResult Compare(const float *ref, const float *out, size_t n, const Tolerance &tol) {
+    CompareResult r;
+    r.count = n;
+    for (size_t i = 0; i < n; ++i) {
+        bool ref_nan = std::isnan(ref[i]);
+        bool out_nan = std::isnan(out[i]);
+        if (ref_nan || out_nan) {
+            if (ref_nan != out_nan && r.mismatches++ == 0)
+                r.first_bad = i;
+            continue;
+        }
+
+        float abs_err = std::fabs(ref[i] - out[i]);
+        float rel_err = ref[i] != 0.0f ? abs_err / std::fabs(ref[i]) : abs_err;
+        int64_t ulp = UlpDistance(ref[i], out[i]);
+
+        r.max_abs_err = std::max(r.max_abs_err, abs_err);
+        r.max_rel_err = std::max(r.max_rel_err, rel_err);
+        r.max_ulp = std::max(r.max_ulp, ulp);
+
+        bool pass = abs_err <= tol.abs || rel_err <= tol.rel || ulp <= tol.ulp;
+        if (!pass && r.mismatches++ == 0)
+            r.first_bad = i;
+    }
+    return r;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Host reference backend
+// ---------------------------------------------------------------------------------------------------------------------
+namespace host_ref {
+
+inline void Axpy(size_t n, float a, const float *x, const float *y, float *z) {
+#pragma omp parallel for simd
+    for (size_t i = 0; i < n; ++i)
+        z[i] += a * x[i] + y[i];
+}
+
+inline void Matmul(size_t M, size_t K, size_t N, const float *A, const float *B, float *C) {
+#pragma omp parallel for
+    for (size_t m = 0; m < M; ++m) {
+        float *c = C + m * N;
+#pragma omp simd
+        for (size_t n = 0; n < N; ++n)
+            c[n] = 0.0f;
+        for (size_t k = 0; k < K; ++k) {
+            const float a = A[m * K + k];
+            const float *b = B + k * N;
+#pragma omp simd
+            for (size_t n = 0; n < N; ++n)
+                c[n] += a * b[n];
+        }
+    }
+}
+
+// Accumulate in double: the reference should be more accurate than the kernel under test.
+inline float SumOfSquares(size_t n, const float *x) {
+    double ss = 0.0;
+#pragma omp parallel for simd reduction(+ : ss)
+    for (size_t i = 0; i < n; ++i)
+        ss += double(x[i]) * double(x[i]);
+    return float(ss);
+}
+
+inline void Silu(size_t n, const float *x, float *y) {
+#pragma omp parallel for simd
+    for (size_t i = 0; i < n; ++i)
+        y[i] = x[i] / (1.0f + std::exp(-x[i]));
+}
+
+inline void RmsNorm(size_t rows, size_t cols, const float *x, const float *weight, float *y, float eps) {
+#pragma omp parallel for
+    for (size_t r = 0; r < rows; ++r) {
+        const float *xr = x + r * cols;
+        float *yr = y + r * cols;
+        double ss = 0.0;
+#pragma omp simd reduction(+ : ss)
+        for (size_t c = 0; c < cols; ++c)
+            ss += double(xr[c]) * double(xr[c]);
+        const float scale = float(1.0 / std::sqrt(ss / cols + eps));
+#pragma omp simd
+        for (size_t c = 0; c < cols; ++c)
+            yr[c] = xr[c] * scale * weight[c];
+    }
+}
+
+} // namespace host_ref
@@ -0,0 +1,464 @@
+#include <CL/sycl.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+Keys:
+  1) Task<T>: a lazy C++20 coroutine, `co_await task` starts it and resumes the caller when it finishes.
+  2) co_await sched.wait(q, e): suspends the coroutine until the sycl::event `e` is complete, instead of e.wait().
+  3) Scheduler: one host thread resumes all suspended coroutines, so many request pipelines share one thread.
+  4) Combinators: when_all / when_any on events, WhenAll on tasks (the first child exception is rethrown to the awaiter).
+
+Blocking vs. co_await:
+
+  blocking (thread per request)               coroutine (one thread, many requests)
+  ---------------------------------------     -------------------------------------------------------
+  submit ─► wait ─► submit ─► wait ─► ...     req0: submit ─► co_await ┐        ┌─► resume ─► submit ...
+  host thread is idle while the device runs   req1:        submit ─► co_await ┤  ...   │
+                                              req2:               submit ─► co_await ┘  scheduler.run()
+
+Wake modes of the scheduler:
+  • Poll:     parked coroutines are checked with event::get_info<command_execution_status>() on every loop.
+  • HostTask: a host_task depending on the event pushes the coroutine handle back to the scheduler,
+              the scheduler thread sleeps on a condition_variable while nothing is ready.
+              (when_any has no single dependency to hang a host_task on, it is always polled)
+
+Note: the coroutine must not be resumed from the host_task thread itself, the host_task only hands
+      the handle over, all coroutines run on the thread that calls Scheduler::run().
+*/
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    // Resume whoever co_awaited this task, or return to the scheduler for a root task.
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            auto cont = h.promise().continuation;
+            return cont ? cont : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    void return_value(T v) { value = std::move(v); }
+    T result() {
+        if (exception)
+            std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    void return_void() {}
+    void result() {
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+};
+
+inline bool IsComplete(const sycl::event &e) {
+    return e.get_info<sycl::info::event::command_execution_status>() == sycl::info::event_command_status::complete;
+}
+
+} // namespace detail
+
+template <typename T>
+class Task {
+public:
+    struct promise_type : detail::Promise<T> {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task(Task &&other) noexcept : h_(std::exchange(other.h_, {})) {}
+    Task &operator=(Task &&) = delete;
+    ~Task() {
+        if (h_)
+            h_.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> cont) noexcept {
+        h_.promise().continuation = cont;
+        return h_;
+    }
+    T await_resume() { return h_.promise().result(); }
+
+    // Hand the coroutine frame over to the scheduler.
+    Handle release() { return std::exchange(h_, {}); }
+
+private:
+    explicit Task(Handle h) : h_(h) {}
+    Handle h_;
+};
+
+class Scheduler {
+public:
+    enum class Wake { Poll, HostTask };
+
+    explicit Scheduler(Wake wake = Wake::Poll) : wake_(wake) {}
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+    ~Scheduler() {
+        for (auto h : roots_)
+            h.destroy();
+    }
+
+    // Start a root task, it runs the next time run() is called.
+    void spawn(Task<> task) {
+        auto h = task.release();
+        roots_.push_back(h);
+        ready_.push_back(h);
+    }
+
+    // Resume a suspended coroutine on the next loop of run(), must be called from the scheduler thread.
+    void schedule(std::coroutine_handle<> h) { ready_.push_back(h); }
+
+    struct EventAwaiter {
+        Scheduler &sched;
+        sycl::queue &q;
+        std::vector<sycl::event> events;
+
+        bool await_ready() const {
+            for (auto &e : events)
+                if (!detail::IsComplete(e))
+                    return false;
+            return true;
+        }
+        void await_suspend(std::coroutine_handle<> h) { sched.park(q, events, h); }
+        void await_resume() const {}
+    };
+
+    struct AnyAwaiter {
+        Scheduler &sched;
+        std::vector<sycl::event> events;
+        size_t index = 0;
+
+        bool await_ready() {
+            for (size_t i = 0; i < events.size(); ++i) {
+                if (detail::IsComplete(events[i])) {
+                    index = i;
+                    return true;
+                }
+            }
+            return false;
+        }
+        void await_suspend(std::coroutine_handle<> h) {
+            sched.park([this] { return await_ready(); }, h);
+        }
+        size_t await_resume() const { return index; }
+    };
+
+    struct PredicateAwaiter {
+        Scheduler &sched;
+        std::function<bool()> pred;
+
+        bool await_ready() const { return pred(); }
+        void await_suspend(std::coroutine_handle<> h) { sched.park(pred, h); }
+        void await_resume() const {}
+    };
+
+    // co_await sched.wait(q, e): resume when e is complete.
+    EventAwaiter wait(sycl::queue &q, sycl::event e) { return {*this, q, {std::move(e)}}; }
+    // co_await sched.when_all(q, events): resume when every event is complete.
+    EventAwaiter when_all(sycl::queue &q, std::vector<sycl::event> events) { return {*this, q, std::move(events)}; }
+    // size_t i = co_await sched.when_any(events): resume when any event is complete, i is its index.
+    AnyAwaiter when_any(std::vector<sycl::event> events) { return {*this, std::move(events)}; }
+    // co_await sched.until(pred): resume when pred() returns true, pred is evaluated on the scheduler thread.
+    PredicateAwaiter until(std::function<bool()> pred) { return {*this, std::move(pred)}; }
+
+    // Drive all tasks until every root task finished. Rethrows the first exception of a root task.
+    void run() {
+        std::exception_ptr first_error;
+        while (!roots_.empty()) {
+            while (!ready_.empty()) {
+                auto h = ready_.front();
+                ready_.pop_front();
+                h.resume();
+            }
+
+            {
+                std::lock_guard<std::mutex> lk(mutex_);
+                pending_callbacks_ -= woken_.size();
+                ready_.insert(ready_.end(), woken_.begin(), woken_.end());
+                woken_.clear();
+            }
+
+            for (auto it = parked_.begin(); it != parked_.end();) {
+                ++polls_;
+                if (it->ready()) {
+                    ready_.push_back(it->h);
+                    it = parked_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            for (auto it = roots_.begin(); it != roots_.end();) {
+                if (!it->done()) {
+                    ++it;
+                    continue;
+                }
+                try {
+                    it->promise().result();
+                } catch (...) {
+                    if (!first_error)
+                        first_error = std::current_exception();
+                }
+                it->destroy();
+                it = roots_.erase(it);
+            }
+
+            if (!ready_.empty() || roots_.empty())
+                continue;
+            if (parked_.empty() && pending_callbacks_ == 0)
+                throw std::logic_error("Scheduler: tasks are suspended but nothing can wake them");
+            if (parked_.empty()) {
+                std::unique_lock<std::mutex> lk(mutex_);
+                cv_.wait(lk, [this] { return !woken_.empty(); });
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        if (first_error)
+            std::rethrow_exception(first_error);
+    }
+
+    size_t polls() const { return polls_; }
+
+private:
+    struct Parked {
+        std::function<bool()> ready;
+        std::coroutine_handle<> h;
+    };
+
+    void park(std::function<bool()> pred, std::coroutine_handle<> h) { parked_.push_back({std::move(pred), h}); }
+
+    void park(sycl::queue &q, const std::vector<sycl::event> &events, std::coroutine_handle<> h) {
+        if (wake_ == Wake::Poll) {
+            park([events] {
+                for (auto &e : events)
+                    if (!detail::IsComplete(e))
+                        return false;
+                return true;
+            }, h);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            ++pending_callbacks_;
+        }
+        q.submit([&](sycl::handler &cgh) {
+            cgh.depends_on(events);
+            cgh.host_task([this, h] {
+                std::lock_guard<std::mutex> lk(mutex_);
+                woken_.push_back(h);
+                cv_.notify_one();
+            });
+        });
+    }
+
+    Wake wake_;
+    std::vector<Task<>::Handle> roots_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::vector<Parked> parked_;
+    size_t polls_ = 0;
+
+    // Shared with host_task threads
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::coroutine_handle<>> woken_;
+    size_t pending_callbacks_ = 0;
+};
+
+namespace detail {
+
+struct WhenAllState {
+    size_t left;
+    std::coroutine_handle<> waiter;
+    std::exception_ptr error;
+};
+
+// Suspends until the last child finished, the last child hands the waiter back to the scheduler, nothing is polled.
+struct WhenAllAwaiter {
+    WhenAllState *state;
+
+    bool await_ready() const noexcept { return state->left == 0; }
+    void await_suspend(std::coroutine_handle<> h) noexcept { state->waiter = h; }
+    void await_resume() const {
+        if (state->error)
+            std::rethrow_exception(state->error);
+    }
+};
+
+// Never throws, the exception is kept for the WhenAll awaiter instead of surfacing as a root error.
+inline Task<> Countdown(Scheduler &sched, Task<> task, std::shared_ptr<WhenAllState> state) {
+    try {
+        co_await task;
+    } catch (...) {
+        if (!state->error)
+            state->error = std::current_exception();
+    }
+    if (--state->left == 0 && state->waiter)
+        sched.schedule(state->waiter);
+}
+
+} // namespace detail
+
+// Run all tasks concurrently on the scheduler, finish when the last one finished.
+// Rethrows the first exception of a child after all children finished.
+inline Task<> WhenAll(Scheduler &sched, std::vector<Task<>> tasks) {
+    auto state = std::make_shared<detail::WhenAllState>(detail::WhenAllState{tasks.size(), {}, {}});
+    for (auto &t : tasks)
+        sched.spawn(detail::Countdown(sched, std::move(t), state));
+    co_await detail::WhenAllAwaiter{state.get()};
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Example: many small independent requests, each one a few steps of upload -> SiLU -> download -> check.
+// ---------------------------------------------------------------------------------------------------------------------
+constexpr int kRequests = 32;
+constexpr int kSteps = 8;
+constexpr size_t N = 16 * 1024;
+
+struct Request {
+    float *host_in;
+    float *host_out;
+    float *dev;
+};
+
+inline sycl::event SubmitStep(sycl::queue &q, const Request &r) {
+    auto e0 = q.memcpy(r.dev, r.host_in, N * sizeof(float));
+    float *dev = r.dev;
+    auto e1 = q.parallel_for(N, e0, [=](auto i) {
+        dev[i] = dev[i] / (1.0f + sycl::exp(-dev[i]));
+    });
+    return q.memcpy(r.host_out, r.dev, N * sizeof(float), e1);
+}
+
+// Host-side work between two submissions: prepare the next input, check the last output.
+inline void PrepareStep(const Request &r, int id, int step) {
+    for (size_t i = 0; i < N; ++i)
+        r.host_in[i] = 0.001f * float((id + step + i) % 64);
+}
+
+inline int CheckStep(const Request &r) {
+    int errors = 0;
+    for (size_t i = 0; i < N; ++i) {
+        float x = r.host_in[i];
+        float ref = x / (1.0f + std::exp(-x));
+        if (std::abs(ref - r.host_out[i]) > 1e-5f)
+            ++errors;
+    }
+    return errors;
+}
+
+Task<> Pipeline(Scheduler &sched, sycl::queue &q, const Request &r, int id, int &errors) {
+    for (int step = 0; step < kSteps; ++step) {
+        PrepareStep(r, id, step);
+        co_await sched.wait(q, SubmitStep(q, r));
+        errors += CheckStep(r);
+    }
+}
+
+// The two kernels may run concurrently, so they write disjoint ranges of `dev`.
+Task<> RaceDemo(Scheduler &sched, sycl::queue &q, float *dev) {
+    constexpr size_t kSmall = 1024;
+    auto small = q.parallel_for(kSmall, [=](auto i) { dev[i] = 1.0f; });
+    auto large = q.parallel_for(N - kSmall, [=](auto i) {
+        float v = 0.0f;
+        for (int k = 0; k < 1000; ++k)
+            v += sycl::sin(float(i + k));
+        dev[kSmall + i] = v;
+    });
+    std::vector<sycl::event> both = {small, large};
+    size_t first = co_await sched.when_any(both);
+    std::cout << "when_any: " << (first == 0 ? "small" : "large") << " kernel finished first" << std::endl;
+    co_await sched.when_all(q, both);
+    std::cout << "when_all: both kernels finished" << std::endl;
+}
+
+int main() {
+    sycl::queue q;
+    std::cout << "Device: " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+    std::vector<Request> requests(kRequests);
+    for (auto &r : requests) {
+        r.host_in = sycl::malloc_host<float>(N, q);
+        r.host_out = sycl::malloc_host<float>(N, q);
+        r.dev = sycl::malloc_device<float>(N, q);
+    }
+
+    {
+        int errors = 0;
+        auto tag_0 = std::chrono::high_resolution_clock::now();
+        for (int id = 0; id < kRequests; ++id) {
+            for (int step = 0; step < kSteps; ++step) {
+                PrepareStep(requests[id], id, step);
+                SubmitStep(q, requests[id]).wait();
+                errors += CheckStep(requests[id]);
+            }
+        }
+        auto tag_1 = std::chrono::high_resolution_clock::now();
+        auto diff_0_1 = std::chrono::duration_cast<std::chrono::microseconds>(tag_1 - tag_0);
+        std::cout << "blocking wait():   " << diff_0_1.count() << " usec, errors: " << errors << std::endl;
+    }
+
+    for (auto wake : {Scheduler::Wake::Poll, Scheduler::Wake::HostTask}) {
+        int errors = 0;
+        Scheduler sched(wake);
+        std::vector<Task<>> pipelines;
+        for (int id = 0; id < kRequests; ++id)
+            pipelines.push_back(Pipeline(sched, q, requests[id], id, errors));
+
+        auto tag_0 = std::chrono::high_resolution_clock::now();
+        sched.spawn(WhenAll(sched, std::move(pipelines)));
+        sched.run();
+        auto tag_1 = std::chrono::high_resolution_clock::now();
+        auto diff_0_1 = std::chrono::duration_cast<std::chrono::microseconds>(tag_1 - tag_0);
+        std::cout << (wake == Scheduler::Wake::Poll ? "co_await (poll):   " : "co_await (host_task): ")
+                  << diff_0_1.count() << " usec, errors: " << errors << ", polls: " << sched.polls() << std::endl;
+    }
+
+    {
+        Scheduler sched;
+        sched.spawn(RaceDemo(sched, q, requests[0].dev));
+        sched.run();
+    }
+
+    for (auto &r : requests) {
+        sycl::free(r.host_in, q);
+        sycl::free(r.host_out, q);
+        sycl::free(r.dev, q);
+    }
+    return 0;
+}